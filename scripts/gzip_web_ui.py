@@ -0,0 +1,60 @@
+# Pre-build script: stages the filesystem image in the build directory with
+# the web UI gzip-compressed, and points the image at that copy. Only the .gz
+# files ship, so the UI takes its compressed size in flash once; the server
+# sends them with Content-Encoding: gzip. Files are only copied or compressed
+# again when the source is newer.
+import gzip
+import os
+import shutil
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+COMPRESSED_FILES = ["index.html"]
+
+
+def is_current(source, target):
+    return os.path.isfile(target) and os.path.getmtime(target) >= os.path.getmtime(source)
+
+
+def compress(source, target, name):
+    with open(source, "rb") as source_file:
+        content = source_file.read()
+    # mtime=0 keeps the output (and the ETag derived from it) reproducible.
+    with open(target, "wb") as target_file:
+        with gzip.GzipFile(filename=name, mode="wb", fileobj=target_file, compresslevel=9, mtime=0) as gz:
+            gz.write(content)
+    print("Compressed %s: %d -> %d bytes" % (name, len(content), os.path.getsize(target)))
+
+
+def stage_filesystem(data_dir, staging_dir):
+    staged = set()
+    for directory, _, files in os.walk(data_dir):
+        relative_dir = os.path.relpath(directory, data_dir)
+        os.makedirs(os.path.join(staging_dir, relative_dir), exist_ok=True)
+        for name in files:
+            relative = os.path.normpath(os.path.join(relative_dir, name))
+            source = os.path.join(data_dir, relative)
+            if relative in COMPRESSED_FILES:
+                relative += ".gz"
+                target = os.path.join(staging_dir, relative)
+                if not is_current(source, target):
+                    compress(source, target, name)
+            else:
+                target = os.path.join(staging_dir, relative)
+                if not is_current(source, target):
+                    shutil.copy2(source, target)
+            staged.add(relative)
+
+    # Files deleted from data/ must not linger in the image.
+    for directory, _, files in os.walk(staging_dir):
+        for name in files:
+            path = os.path.join(directory, name)
+            if os.path.normpath(os.path.relpath(path, staging_dir)) not in staged:
+                os.remove(path)
+
+
+data_dir = env.subst("$PROJECT_DATA_DIR")  # noqa: F821
+staging_dir = os.path.join(env.subst("$PROJECT_BUILD_DIR"), "webfs")  # noqa: F821
+if os.path.isdir(data_dir):
+    stage_filesystem(data_dir, staging_dir)
+    env.Replace(PROJECT_DATA_DIR=staging_dir)  # noqa: F821
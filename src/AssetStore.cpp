@@ -0,0 +1,454 @@
+#include "AssetStore.hpp"
+
+#include <ArduinoJson.h>
+#include <mbedtls/sha256.h>
+
+namespace
+{
+constexpr size_t kHashReadChunkBytes = 512;
+constexpr const char *kManifestTempPath = "/.assets/manifest.json.tmp";
+
+bool isHexDigit(char c)
+{
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+} // namespace
+
+AssetStore::AssetStore()
+    : fs_(nullptr),
+      writable_(false),
+      deduplicatedUploads_(0),
+      skippedUploads_(0)
+{
+}
+
+bool AssetStore::begin(fs::FS &fs)
+{
+  fs_ = &fs;
+  if (!fs_->exists(kDirectory) && !fs_->mkdir(kDirectory))
+  {
+    Serial.println(F("[E] Failed to create asset store directory"));
+    return false;
+  }
+
+  if (fs_->exists(kCorruptManifestPath))
+  {
+    Serial.printf("[E] Asset manifest kept at %s needs recovery; stored files are read only.\n",
+                  kCorruptManifestPath);
+    return false;
+  }
+
+  if (!load())
+  {
+    // Set aside rather than overwritten by the next save, which would drop
+    // every reference it holds.
+    if (fs_->exists(kManifestPath) && fs_->rename(kManifestPath, kCorruptManifestPath))
+    {
+      Serial.printf("[E] Moved unreadable asset manifest to %s; stored files are read only.\n",
+                    kCorruptManifestPath);
+    }
+    references_.clear();
+    return false;
+  }
+
+  writable_ = true;
+  removeUnreferencedBlobs();
+  return true;
+}
+
+bool AssetStore::isWritable() const
+{
+  return writable_;
+}
+
+bool AssetStore::normalizeHash(const String &input, String &hash)
+{
+  // Either the full SHA-256 or exactly its 128-bit prefix; anything else is a typo.
+  if (input.length() != kHashLength && input.length() != kHashLength * 2)
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < input.length(); i++)
+  {
+    if (!isHexDigit(input[i]))
+    {
+      return false;
+    }
+  }
+
+  hash = input.substring(0, kHashLength);
+  hash.toLowerCase();
+  return true;
+}
+
+bool AssetStore::hashFile(const String &path, String &hash) const
+{
+  File file = fs_->open(path, FILE_READ);
+  if (!file)
+  {
+    return false;
+  }
+
+  mbedtls_sha256_context context;
+  mbedtls_sha256_init(&context);
+  mbedtls_sha256_starts_ret(&context, 0);
+
+  uint8_t buffer[kHashReadChunkBytes];
+  size_t bytesRead = 0;
+  while ((bytesRead = file.read(buffer, sizeof(buffer))) > 0)
+  {
+    mbedtls_sha256_update_ret(&context, buffer, bytesRead);
+  }
+  file.close();
+
+  uint8_t digest[32];
+  mbedtls_sha256_finish_ret(&context, digest);
+  mbedtls_sha256_free(&context);
+
+  char hex[kHashLength + 1];
+  for (size_t i = 0; i < kHashLength / 2; i++)
+  {
+    snprintf(hex + i * 2, 3, "%02x", digest[i]);
+  }
+  hash = hex;
+  return true;
+}
+
+const std::vector<AssetStore::Reference> &AssetStore::getReferences() const
+{
+  return references_;
+}
+
+const AssetStore::Reference *AssetStore::find(const String &path) const
+{
+  const int index = findIndex(path);
+  return index >= 0 ? &references_[index] : nullptr;
+}
+
+const AssetStore::Reference *AssetStore::findByHash(const String &hash) const
+{
+  for (const auto &reference : references_)
+  {
+    if (reference.hash == hash)
+    {
+      return &reference;
+    }
+  }
+  return nullptr;
+}
+
+String AssetStore::getBlobPath(const String &hash) const
+{
+  return String(kDirectory) + "/" + hash;
+}
+
+bool AssetStore::store(const String &tempPath, const String &path, bool &deduplicated)
+{
+  deduplicated = false;
+  if (!writable_)
+  {
+    return false;
+  }
+
+  String hash;
+  if (!hashFile(tempPath, hash))
+  {
+    return false;
+  }
+
+  File file = fs_->open(tempPath, FILE_READ);
+  const size_t size = file ? file.size() : 0;
+  file.close();
+
+  const String blobPath = getBlobPath(hash);
+  if (fs_->exists(blobPath))
+  {
+    fs_->remove(tempPath);
+    deduplicated = true;
+    deduplicatedUploads_++;
+  }
+  else if (!fs_->rename(tempPath, blobPath))
+  {
+    return false;
+  }
+
+  if (!setReference(path, hash, size))
+  {
+    // Not referenced by the saved manifest either; nothing else would remove it.
+    releaseBlob(hash);
+    return false;
+  }
+  return true;
+}
+
+bool AssetStore::link(const String &hash, const String &path)
+{
+  if (!writable_)
+  {
+    return false;
+  }
+
+  const Reference *existing = findByHash(hash);
+  if (existing == nullptr || !fs_->exists(getBlobPath(hash)))
+  {
+    return false;
+  }
+
+  skippedUploads_++;
+  return setReference(path, hash, existing->size);
+}
+
+bool AssetStore::unlink(const String &path)
+{
+  const int index = findIndex(path);
+  if (!writable_ || index < 0)
+  {
+    return false;
+  }
+
+  const Reference removed = references_[index];
+  references_.erase(references_.begin() + index);
+  if (!save())
+  {
+    references_.insert(references_.begin() + index, removed);
+    return false;
+  }
+  // Only once the saved manifest no longer points at it.
+  releaseBlob(removed.hash);
+  return true;
+}
+
+bool AssetStore::rename(const String &from, const String &to)
+{
+  const int index = findIndex(from);
+  if (!writable_ || index < 0 || findIndex(to) >= 0)
+  {
+    return false;
+  }
+
+  references_[index].path = to;
+  if (!save())
+  {
+    references_[index].path = from;
+    return false;
+  }
+  return true;
+}
+
+AssetStore::Stats AssetStore::getStats() const
+{
+  Stats stats;
+  stats.referenceCount = references_.size();
+  stats.deduplicatedUploads = deduplicatedUploads_;
+  stats.skippedUploads = skippedUploads_;
+
+  for (size_t i = 0; i < references_.size(); i++)
+  {
+    stats.referencedBytes += references_[i].size;
+
+    // A blob is counted at its first reference only.
+    bool seenBefore = false;
+    for (size_t j = 0; j < i && !seenBefore; j++)
+    {
+      seenBefore = references_[j].hash == references_[i].hash;
+    }
+    if (!seenBefore)
+    {
+      stats.blobCount++;
+      stats.storedBytes += references_[i].size;
+    }
+  }
+
+  return stats;
+}
+
+int AssetStore::findIndex(const String &path) const
+{
+  for (size_t i = 0; i < references_.size(); i++)
+  {
+    if (references_[i].path == path)
+    {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+size_t AssetStore::countReferences(const String &hash) const
+{
+  size_t count = 0;
+  for (const auto &reference : references_)
+  {
+    if (reference.hash == hash)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+bool AssetStore::setReference(const String &path, const String &hash, size_t size)
+{
+  const int index = findIndex(path);
+  if (index >= 0)
+  {
+    const Reference previous = references_[index];
+    references_[index].hash = hash;
+    references_[index].size = size;
+    references_[index].modified = time(nullptr);
+    if (!save())
+    {
+      references_[index] = previous;
+      return false;
+    }
+    if (previous.hash != hash)
+    {
+      releaseBlob(previous.hash);
+    }
+    return true;
+  }
+
+  Reference reference;
+  reference.path = path;
+  reference.hash = hash;
+  reference.size = size;
+  reference.modified = time(nullptr);
+  references_.push_back(reference);
+  if (!save())
+  {
+    references_.pop_back();
+    return false;
+  }
+  return true;
+}
+
+void AssetStore::releaseBlob(const String &hash)
+{
+  if (countReferences(hash) == 0)
+  {
+    fs_->remove(getBlobPath(hash));
+  }
+}
+
+void AssetStore::removeUnreferencedBlobs()
+{
+  File directory = fs_->open(kDirectory);
+  if (!directory || !directory.isDirectory())
+  {
+    return;
+  }
+
+  std::vector<String> unreferenced;
+  File entry = directory.openNextFile();
+  while (entry)
+  {
+    const String name = entry.name();
+    String hash;
+    // Only blob names; the manifest and its temp copy never look like a hash.
+    if (!entry.isDirectory() && normalizeHash(name, hash) && hash == name && countReferences(hash) == 0)
+    {
+      unreferenced.push_back(getBlobPath(hash));
+    }
+    entry.close();
+    entry = directory.openNextFile();
+  }
+  directory.close();
+
+  for (const auto &path : unreferenced)
+  {
+    Serial.printf("[I] Removing unreferenced asset %s\n", path.c_str());
+    fs_->remove(path);
+  }
+}
+
+bool AssetStore::load()
+{
+  references_.clear();
+  if (!fs_->exists(kManifestPath))
+  {
+    // A power cut between closing and renaming the temp copy leaves only that.
+    if (!fs_->exists(kManifestTempPath))
+    {
+      return true;
+    }
+    Serial.println(F("[W] Recovering asset manifest from its temp copy."));
+    if (!fs_->rename(kManifestTempPath, kManifestPath))
+    {
+      Serial.println(F("[E] Could not recover asset manifest."));
+      return false;
+    }
+  }
+  else if (fs_->exists(kManifestTempPath))
+  {
+    // An interrupted save; the manifest itself is still the last complete one.
+    fs_->remove(kManifestTempPath);
+  }
+
+  File file = fs_->open(kManifestPath, FILE_READ);
+  if (!file)
+  {
+    Serial.println(F("[E] Could not open asset manifest."));
+    return false;
+  }
+
+  JsonDocument document;
+  const DeserializationError error = deserializeJson(document, file);
+  file.close();
+  if (error || !document.is<JsonArray>())
+  {
+    Serial.printf("[E] Failed to parse asset manifest: %s\n", error.c_str());
+    return false;
+  }
+
+  for (JsonObject object : document.as<JsonArray>())
+  {
+    Reference reference;
+    reference.path = object["path"].as<String>();
+    reference.hash = object["hash"].as<String>();
+    reference.size = object["size"].as<size_t>();
+    reference.modified = object["modified"].as<time_t>();
+
+    if (reference.path.isEmpty() || !fs_->exists(getBlobPath(reference.hash)))
+    {
+      Serial.printf("[W] Dropping asset reference without content: %s\n", reference.path.c_str());
+      continue;
+    }
+    references_.push_back(reference);
+  }
+
+  return true;
+}
+
+bool AssetStore::save() const
+{
+  JsonDocument document;
+  JsonArray array = document.to<JsonArray>();
+  for (const auto &reference : references_)
+  {
+    JsonObject object = array.add<JsonObject>();
+    object["path"] = reference.path;
+    object["hash"] = reference.hash;
+    object["size"] = reference.size;
+    object["modified"] = reference.modified;
+  }
+
+  // Written aside and renamed over the old one (LittleFS replaces the target
+  // atomically), so a power cut leaves either the old or the new manifest.
+  File file = fs_->open(kManifestTempPath, FILE_WRITE);
+  if (!file)
+  {
+    Serial.println(F("[E] Could not open asset manifest for writing."));
+    return false;
+  }
+
+  const size_t written = serializeJson(document, file);
+  file.close();
+  if (written == 0)
+  {
+    fs_->remove(kManifestTempPath);
+    return false;
+  }
+
+  return fs_->rename(kManifestTempPath, kManifestPath);
+}
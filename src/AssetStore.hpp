@@ -0,0 +1,81 @@
+#ifndef ASSET_STORE_HPP
+#define ASSET_STORE_HPP
+
+#include <FS.h>
+
+#include <Arduino.h>
+#include <time.h>
+#include <vector>
+
+// Content-addressed file storage. Each distinct file content is kept once as
+// "/.assets/<hash>", and file paths are references to it in a manifest, so the
+// same GIF uploaded under several names only takes its flash space once.
+// The hash is the first 128 bits of the SHA-256 of the content, in lowercase hex.
+class AssetStore {
+public:
+  static constexpr const char *kDirectory = "/.assets";
+  static constexpr const char *kManifestPath = "/.assets/manifest.json";
+  // An unreadable manifest is moved here. While it exists the store is read
+  // only, so no save can replace the references it still holds; restoring it
+  // over kManifestPath or deleting it ends that.
+  static constexpr const char *kCorruptManifestPath = "/.assets/manifest.json.corrupt";
+  static constexpr size_t kHashLength = 32;
+
+  struct Reference {
+    String path;
+    String hash;
+    size_t size = 0;
+    time_t modified = 0;
+  };
+
+  struct Stats {
+    size_t blobCount = 0;
+    size_t storedBytes = 0;
+    size_t referenceCount = 0;
+    size_t referencedBytes = 0;
+    size_t deduplicatedUploads = 0;
+    size_t skippedUploads = 0;
+  };
+
+  AssetStore();
+
+  bool begin(fs::FS &fs);
+  bool isWritable() const;
+
+  // Accepts a SHA-256 (64 hex digits) or its 128-bit prefix (32) and returns the store key.
+  static bool normalizeHash(const String &input, String &hash);
+  bool hashFile(const String &path, String &hash) const;
+
+  const std::vector<Reference> &getReferences() const;
+  const Reference *find(const String &path) const;
+  const Reference *findByHash(const String &hash) const;
+  String getBlobPath(const String &hash) const;
+
+  // Moves `tempPath` into the store and points `path` at it. When the content
+  // is already stored the temp file is dropped and `deduplicated` is set.
+  bool store(const String &tempPath, const String &path, bool &deduplicated);
+  // Points `path` at an already stored hash without any upload.
+  bool link(const String &hash, const String &path);
+  bool unlink(const String &path);
+  bool rename(const String &from, const String &to);
+
+  Stats getStats() const;
+
+private:
+  int findIndex(const String &path) const;
+  size_t countReferences(const String &hash) const;
+  bool setReference(const String &path, const String &hash, size_t size);
+  void releaseBlob(const String &hash);
+  // Removes blobs no reference points at (left by an interrupted upload).
+  void removeUnreferencedBlobs();
+  bool load();
+  bool save() const;
+
+  fs::FS *fs_;
+  bool writable_;
+  std::vector<Reference> references_;
+  size_t deduplicatedUploads_;
+  size_t skippedUploads_;
+};
+
+#endif // ASSET_STORE_HPP
@@ -1,23 +1,95 @@
 #include "BLEController.hpp"
 #include "NimBLEDevice.h"
+#include "HeapMonitor.hpp"
 
-BLEController::CharacteristicCallbacks::CharacteristicCallbacks(EmotionState &emotionState, CapabilityManager &capabilityManager, EarController &earController)
-    : emotionState_(emotionState), capabilityManager_(capabilityManager), earController_(earController)
+#include <math.h>
+
+namespace
 {
+    // Minimum spacing of state notifications; changes in between are coalesced.
+    constexpr unsigned long kStateIntervalMs = 200;
 }
 
-void BLEController::CharacteristicCallbacks::setEmotionAndApplyEars(const String &emotionPath)
+BLEController::CharacteristicCallbacks::CharacteristicCallbacks(BLEController &controller)
+    : controller_(controller)
 {
-    emotionState_.setCurrentEmotion(emotionPath);
-    earController_.applyEmotionEarColor(emotionState_.getCurrentEmotionDefinition());
 }
 
 void BLEController::CharacteristicCallbacks::onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo)
 {
-    auto emotions = emotionState_.getEmotionDefinitions();
-    auto emotionCount = emotions.size();
+    const NimBLEAttValue value = pCharacteristic->getValue();
+    if (value.size() == 0)
+    {
+        return;
+    }
 
-    String characteristicValue = String(pCharacteristic->getValue().c_str());
+    PendingCommand pending;
+    // Leaves room for the terminator handleTextCommand() relies on.
+    if (value.size() >= sizeof(pending.command.payload))
+    {
+        controller_.droppedCommands_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    memcpy(pending.command.payload, value.data(), value.size());
+    pending.command.payload[value.size()] = '\0';
+    pending.command.length = static_cast<uint8_t>(value.size());
+
+    if (!controller_.commandQueue_.push(pending))
+    {
+        controller_.droppedCommands_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+BLEController::ProtocolCallbacks::ProtocolCallbacks(BLEController &controller)
+    : controller_(controller)
+{
+}
+
+void BLEController::ProtocolCallbacks::onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo)
+{
+    const NimBLEAttValue value = pCharacteristic->getValue();
+    std::vector<BleProtocol::Command> commands;
+    if (!BleProtocol::decodeCommands(value.data(), value.size(), commands))
+    {
+        controller_.sendStatus(pCharacteristic, connInfo.getMTU(), connInfo.getConnHandle(), BleProtocol::Command(),
+                               BleProtocol::Status::InvalidPayload);
+        return;
+    }
+
+    PendingCommand pending;
+    pending.binary = true;
+    pending.connHandle = connInfo.getConnHandle();
+    pending.mtu = connInfo.getMTU();
+    for (const auto &command : commands)
+    {
+        pending.command = command;
+        if (!controller_.commandQueue_.push(pending))
+        {
+            // Answered here so the remote can retry; nothing else is touched.
+            controller_.droppedCommands_.fetch_add(1, std::memory_order_relaxed);
+            controller_.sendStatus(pCharacteristic, pending.mtu, pending.connHandle, command, BleProtocol::Status::Busy);
+        }
+    }
+}
+
+void BLEController::setEmotionAndApplyEars(uint16_t emotionId)
+{
+    const auto emotionLock = emotionState_.lock();
+    if (!emotionState_.setCurrentEmotionById(emotionId))
+    {
+        Serial.printf("[W] Unknown emotion id: %u\n", emotionId);
+        return;
+    }
+    Serial.println("[I] Setting emotion " + emotionState_.getCurrentEmotion());
+    earController_.applyEmotionEarColor(emotionState_.getCurrentEmotionDefinition());
+}
+
+void BLEController::handleTextCommand(const String &characteristicValue)
+{
+    // Held for the whole command: emotions below is a reference into the state.
+    const auto emotionLock = emotionState_.lock();
+    const auto &emotions = emotionState_.getEmotionDefinitions();
+    const size_t emotionCount = emotions.size();
 
     Serial.println("[I] BT Received: " + String(characteristicValue));
 
@@ -33,6 +105,15 @@ void BLEController::CharacteristicCallbacks::onWrite(NimBLECharacteristic *pChar
         return;
     }
 
+    if (characteristicValue == "?stats")
+    {
+        char statsMessage[96];
+        const size_t statsLength = frameStats_.formatSummary(statsMessage, sizeof(statsMessage));
+        pCharacteristic->setValue(reinterpret_cast<const uint8_t *>(statsMessage), statsLength);
+        pCharacteristic->notify(true);
+        return;
+    }
+
     if (characteristicValue.charAt(0) == '?')
     {
         auto capabilities = capabilityManager_.getAvailableCapabilities();
@@ -60,6 +141,22 @@ void BLEController::CharacteristicCallbacks::onWrite(NimBLECharacteristic *pChar
             return;
         }
 
+        if (characteristicValue == "?ids")
+        {
+            String idsMessage;
+            for (const auto &emotion : emotions)
+            {
+                idsMessage += "I:";
+                idsMessage += emotion.id;
+                idsMessage += "=";
+                idsMessage += emotion.name;
+                idsMessage += ";";
+            }
+            pCharacteristic->setValue(idsMessage);
+            pCharacteristic->notify(true);
+            return;
+        }
+
         if (characteristicValue == "?all")
         {
             Serial.println("[I] message:"+ availableEmotionsMessage + availableCapabilitiesMessage);
@@ -73,6 +170,16 @@ void BLEController::CharacteristicCallbacks::onWrite(NimBLECharacteristic *pChar
         return;
     }
 
+    if (characteristicValue.charAt(0) == '#')
+    { // emotion id, see "?ids"
+        const long id = characteristicValue.substring(1).toInt();
+        if (id > 0 && id <= UINT16_MAX)
+        {
+            setEmotionAndApplyEars(static_cast<uint16_t>(id));
+        }
+        return;
+    }
+
     if (characteristicValue.charAt(0) == ';')
     { // command
         if (characteristicValue.startsWith(";cap:"))
@@ -97,38 +204,144 @@ void BLEController::CharacteristicCallbacks::onWrite(NimBLECharacteristic *pChar
         }
         else
         {
-            auto emotionName = characteristicValue.substring(1);
-            for (int i = 0; i < emotionCount; i++)
+            const EmotionDefinition *emotion = emotionState_.getEmotionDefinitionByName(characteristicValue.substring(1));
+            if (emotion != nullptr)
             {
-                auto emotion = emotions[i];
-                if (emotionName == emotion.name)
-                {
-                    Serial.println("[I] Setting emotion" + emotion.path);
-                    setEmotionAndApplyEars(emotion.path);
-                    return;
-                }
+                setEmotionAndApplyEars(emotion->id);
             }
         }
         return;
     }
 
-    if (characteristicValue.toInt() > 0 && characteristicValue.toInt() <= emotionCount)
+    const long position = characteristicValue.toInt();
+    if (position > 0 && static_cast<size_t>(position) <= emotionCount)
     { // legacy remote reasons
-        auto newEmotion = emotions[characteristicValue.toInt() - 1];
-        Serial.println("[I] Setting emotion" + newEmotion.path);
-        setEmotionAndApplyEars(newEmotion.path);
+        setEmotionAndApplyEars(emotions[position - 1].id);
+        return;
+    }
+
+    const EmotionDefinition *emotion = emotionState_.getEmotionDefinitionByName(characteristicValue);
+    if (emotion != nullptr)
+    {
+        setEmotionAndApplyEars(emotion->id);
+    }
+}
+
+void BLEController::executeCommand(const BleProtocol::Command &command, BleProtocol::ResponseWriter &writer)
+{
+    using BleProtocol::Opcode;
+    using BleProtocol::Status;
+
+    const auto emotionLock = emotionState_.lock();
+    switch (command.opcode)
+    {
+    case Opcode::GetInfo:
+    {
+        uint8_t info[6];
+        info[0] = BleProtocol::kVersion;
+        BleProtocol::writeUint16(info + 1, static_cast<uint16_t>(emotionState_.getEmotionDefinitions().size()));
+        info[3] = static_cast<uint8_t>(capabilityManager_.getCapabilityCount());
+        BleProtocol::writeUint16(info + 4, emotionState_.getCurrentEmotionId());
+        writer.begin(command);
+        writer.addEntry(info, sizeof(info));
+        writer.finish();
+        return;
+    }
+    case Opcode::ListEmotions:
+    {
+        writer.begin(command);
+        for (const auto &emotion : emotionState_.getEmotionDefinitions())
+        {
+            uint8_t id[2];
+            BleProtocol::writeUint16(id, emotion.id);
+            writeNamedEntry(writer, id, sizeof(id), emotion.name);
+        }
+        writer.finish();
         return;
     }
-    
-    for (int i = 0; i < emotionCount; i++)
+    case Opcode::ListCapabilities:
     {
-        auto emotion = emotions[i];
-        if (characteristicValue == emotion.name)
+        writer.begin(command);
+        const size_t count = capabilityManager_.getCapabilityCount();
+        for (size_t index = 0; index < count && index <= UINT8_MAX; ++index)
         {
-            Serial.println("[I] Setting emotion" + emotion.path);
-            setEmotionAndApplyEars(emotion.path);
+            const uint8_t key = static_cast<uint8_t>(index);
+            writeNamedEntry(writer, &key, sizeof(key), capabilityManager_.getCapability(index)->getName());
         }
+        writer.finish();
+        return;
     }
+    case Opcode::SetEmotion:
+    {
+        if (command.length != 2)
+        {
+            writer.sendStatus(command, Status::InvalidPayload);
+            return;
+        }
+        if (!emotionState_.setCurrentEmotionById(BleProtocol::readUint16(command.payload)))
+        {
+            writer.sendStatus(command, Status::NotFound);
+            return;
+        }
+        earController_.applyEmotionEarColor(emotionState_.getCurrentEmotionDefinition());
+        writer.sendStatus(command, Status::Ok);
+        return;
+    }
+    case Opcode::RunCapability:
+    {
+        if (command.length != 1)
+        {
+            writer.sendStatus(command, Status::InvalidPayload);
+            return;
+        }
+        Capability *capability = capabilityManager_.getCapability(command.payload[0]);
+        if (capability == nullptr)
+        {
+            writer.sendStatus(command, Status::NotFound);
+            return;
+        }
+        capability->handle();
+        writer.sendStatus(command, Status::Ok);
+        return;
+    }
+    case Opcode::GetStats:
+    {
+        char summary[96];
+        const size_t summaryLength = frameStats_.formatSummary(summary, sizeof(summary));
+        const size_t chunkSize = writer.getMaxEntrySize();
+        writer.begin(command);
+        for (size_t offset = 0; offset < summaryLength; offset += chunkSize)
+        {
+            const size_t remaining = summaryLength - offset;
+            writer.addEntry(reinterpret_cast<const uint8_t *>(summary) + offset, remaining < chunkSize ? remaining : chunkSize);
+        }
+        writer.finish();
+        return;
+    }
+    }
+
+    writer.sendStatus(command, Status::UnknownOpcode);
+}
+
+void BLEController::writeNamedEntry(BleProtocol::ResponseWriter &writer, const uint8_t *key, size_t keyLength, const String &name)
+{
+    // Names are cut to fit one segment; remotes that need them whole negotiate a larger MTU.
+    uint8_t entry[UINT8_MAX];
+    size_t nameLength = name.length();
+    const size_t maxNameLength = writer.getMaxEntrySize() - keyLength - 1;
+    if (nameLength > maxNameLength)
+    {
+        nameLength = maxNameLength;
+    }
+    if (nameLength > sizeof(entry) - keyLength - 1)
+    {
+        nameLength = sizeof(entry) - keyLength - 1;
+    }
+
+    memcpy(entry, key, keyLength);
+    entry[keyLength] = static_cast<uint8_t>(nameLength);
+    memcpy(entry + keyLength + 1, name.c_str(), nameLength);
+    writer.addEntry(entry, keyLength + 1 + nameLength);
 }
 
 class ServerCallbacks : public NimBLEServerCallbacks
@@ -139,14 +352,17 @@ class ServerCallbacks : public NimBLEServerCallbacks
     }
 } serverCallbacks;
 
-BLEController::BLEController(EmotionState &emotionState, CapabilityManager &capabilityManager, EarController &earController)
-  :  emotionState_(emotionState), capabilityManager_(capabilityManager), earController_(earController)
+BLEController::BLEController(EmotionState &emotionState, CapabilityManager &capabilityManager, EarController &earController,
+                             FanController &fanController, const StateStore &stateStore, const FrameStats &frameStats)
+  :  pCharacteristic(nullptr), pProtocolCharacteristic(nullptr), pStateCharacteristic(nullptr), pAdvertising(nullptr),
+     emotionState_(emotionState), capabilityManager_(capabilityManager), earController_(earController),
+     fanController_(fanController), stateStore_(stateStore), frameStats_(frameStats),
+     sentState_{}, hasSentState_(false), lastStateCheckMillis_(0), droppedCommands_(0)
 {
 }
 
 bool BLEController::begin()
 {
-    auto emotions = emotionState_.getEmotionDefinitions();
     std::string stdStr("Proto", 5);
     BLEDevice::init(stdStr);
     NimBLEDevice::setPower(ESP_PWR_LVL_P9);
@@ -160,12 +376,22 @@ bool BLEController::begin()
                                                      NIMBLE_PROPERTY::BROADCAST | NIMBLE_PROPERTY::READ |
                                                          NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::WRITE |
                                                          NIMBLE_PROPERTY::INDICATE);
-    pCharacteristic->setValue(emotions.size());
+    {
+        const auto emotionLock = emotionState_.lock();
+        pCharacteristic->setValue(emotionState_.getEmotionDefinitions().size());
+    }
 
-    auto chrCallbacks = new CharacteristicCallbacks(emotionState_, capabilityManager_, earController_);
+    auto chrCallbacks = new CharacteristicCallbacks(*this);
 
     pCharacteristic->setCallbacks(chrCallbacks);
 
+    pProtocolCharacteristic = pService->createCharacteristic("ffe2",
+                                                             NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR |
+                                                                 NIMBLE_PROPERTY::NOTIFY);
+    pProtocolCharacteristic->setCallbacks(new ProtocolCallbacks(*this));
+
+    pStateCharacteristic = pService->createCharacteristic("ffe3", NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
+
     if (!pService->start())
     {
         return false;
@@ -182,3 +408,89 @@ bool BLEController::begin()
 
     return true;
 }
+
+void BLEController::update()
+{
+    runCommands();
+    publishState();
+}
+
+void BLEController::publishState()
+{
+    if (pStateCharacteristic == nullptr)
+    {
+        return;
+    }
+
+    const unsigned long now = millis();
+    if (hasSentState_ && now - lastStateCheckMillis_ < kStateIntervalMs)
+    {
+        return;
+    }
+    lastStateCheckMillis_ = now;
+
+    StateStore::Snapshot snapshot;
+    stateStore_.read(snapshot);
+
+    BleProtocol::State state;
+    state.emotionId = snapshot.emotionId;
+    state.brightness = snapshot.brightness;
+    const int maxDutyCycle = fanController_.getMaxDutyCycle();
+    state.fanPercent = maxDutyCycle > 0 ? static_cast<uint8_t>((snapshot.fanDutyCycle * 100L + maxDutyCycle / 2) / maxDutyCycle) : 0;
+    if (snapshot.hasPower)
+    {
+        state.flags |= BleProtocol::kStateFlagPower;
+        state.millivolts = static_cast<uint16_t>(constrain(lroundf(snapshot.voltage * 1000.0f), 0L, static_cast<long>(UINT16_MAX)));
+        state.milliamps = static_cast<int16_t>(constrain(lroundf(snapshot.currentMilliamps), static_cast<long>(INT16_MIN), static_cast<long>(INT16_MAX)));
+    }
+
+    uint8_t encoded[BleProtocol::kStateSize];
+    BleProtocol::encodeState(state, encoded);
+    if (hasSentState_ && memcmp(encoded, sentState_, sizeof(encoded)) == 0)
+    {
+        return;
+    }
+    memcpy(sentState_, encoded, sizeof(encoded));
+    hasSentState_ = true;
+
+    // The value is kept current for reads even when nobody is subscribed.
+    pStateCharacteristic->setValue(encoded, sizeof(encoded));
+    if (pServer->getConnectedCount() > 0)
+    {
+        pStateCharacteristic->notify();
+    }
+}
+
+void BLEController::runCommands()
+{
+    const uint32_t dropped = droppedCommands_.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+        Serial.printf("[W] BLE: %lu commands dropped, queue full or too long\n", static_cast<unsigned long>(dropped));
+    }
+
+    for (size_t count = 0; count < kCommandQueueSize && commandQueue_.pop(pendingCommand_); ++count)
+    {
+        HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Ble);
+
+        if (!pendingCommand_.binary)
+        {
+            handleTextCommand(String(reinterpret_cast<const char *>(pendingCommand_.command.payload)));
+            continue;
+        }
+
+        const uint16_t connHandle = pendingCommand_.connHandle;
+        NimBLECharacteristic *characteristic = pProtocolCharacteristic;
+        BleProtocol::ResponseWriter writer(pendingCommand_.mtu, [characteristic, connHandle](const uint8_t *data, size_t length)
+                                           { characteristic->notify(data, length, connHandle); });
+        executeCommand(pendingCommand_.command, writer);
+    }
+}
+
+void BLEController::sendStatus(NimBLECharacteristic *characteristic, uint16_t mtu, uint16_t connHandle,
+                               const BleProtocol::Command &command, BleProtocol::Status status)
+{
+    BleProtocol::ResponseWriter writer(mtu, [characteristic, connHandle](const uint8_t *data, size_t length)
+                                       { characteristic->notify(data, length, connHandle); });
+    writer.sendStatus(command, status);
+}
@@ -2,37 +2,89 @@
 #define BLE_CONTROLLER_HPP
 
 #include "NimBLEDevice.h"
+#include "BleProtocol.hpp"
 #include "FileManager.hpp"
 #include "EmotionState.hpp"
 #include "EarController.hpp"
+#include "FanController.hpp"
+#include "StateStore.hpp"
 #include "Capabilities/CapabilityManager.hpp"
+#include "FaceDisplay/FrameStats.hpp"
+#include "SpscQueue.hpp"
 
 #include <Arduino.h>
+#include <atomic>
 
 class BLEController 
 {
     public:
-        BLEController(EmotionState &emotionState, CapabilityManager &capabilityManager, EarController &earController);
+        BLEController(EmotionState &emotionState, CapabilityManager &capabilityManager, EarController &earController,
+                      FanController &fanController, const StateStore &stateStore, const FrameStats &frameStats);
         bool begin();
+        // Call from loop() once begin() returned. Runs the commands queued by
+        // the NimBLE host task and publishes state changes on ffe3.
         void update();
     private:
+        // One remote command, queued by the write callbacks and run by update().
+        struct PendingCommand
+        {
+            bool binary = false;
+            uint16_t connHandle = 0;
+            uint16_t mtu = 0;
+            // Text commands are stored NUL-terminated in the payload.
+            BleProtocol::Command command;
+        };
+
+        static constexpr size_t kCommandQueueSize = 16;
+
         BLEServer *pServer = NULL;
         BLECharacteristic * pCharacteristic;
+        BLECharacteristic * pProtocolCharacteristic;
+        BLECharacteristic * pStateCharacteristic;
         BLEAdvertising* pAdvertising;
         EmotionState &emotionState_;
         CapabilityManager &capabilityManager_;
         EarController &earController_;
+        FanController &fanController_;
+        const StateStore &stateStore_;
+        const FrameStats &frameStats_;
+
+        void runCommands();
+        void handleTextCommand(const String &characteristicValue);
+        void executeCommand(const BleProtocol::Command &command, BleProtocol::ResponseWriter &writer);
+        void writeNamedEntry(BleProtocol::ResponseWriter &writer, const uint8_t *key, size_t keyLength, const String &name);
+        void setEmotionAndApplyEars(uint16_t emotionId);
+        static void sendStatus(NimBLECharacteristic *characteristic, uint16_t mtu, uint16_t connHandle,
+                               const BleProtocol::Command &command, BleProtocol::Status status);
+        void publishState();
+
+        uint8_t sentState_[BleProtocol::kStateSize];
+        bool hasSentState_;
+        unsigned long lastStateCheckMillis_;
+
+        // All write callbacks run on the NimBLE host task, the only producer.
+        SpscQueue<PendingCommand, kCommandQueueSize> commandQueue_;
+        PendingCommand pendingCommand_;
+        std::atomic<uint32_t> droppedCommands_;
 
+        // Text commands on ffe1.
         class CharacteristicCallbacks : public NimBLECharacteristicCallbacks {
             public:
-                CharacteristicCallbacks(EmotionState &emotionState, CapabilityManager &capabilityManager, EarController &earController);
+                explicit CharacteristicCallbacks(BLEController &controller);
+                void onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo) override;
+
+            private:
+                BLEController &controller_;
+        };
+
+        // Binary protocol on ffe2, see BleProtocol.hpp.
+        class ProtocolCallbacks : public NimBLECharacteristicCallbacks {
+            public:
+                explicit ProtocolCallbacks(BLEController &controller);
                 void onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo) override;
 
             private:
-                EmotionState &emotionState_;
-                CapabilityManager &capabilityManager_;
-                EarController &earController_;
-                void setEmotionAndApplyEars(const String &emotionPath);
+                BLEController &controller_;
         };
 };
 
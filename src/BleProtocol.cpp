@@ -0,0 +1,187 @@
+#include "BleProtocol.hpp"
+
+#include <string.h>
+
+namespace BleProtocol
+{
+  bool decodeCommands(const uint8_t *data, size_t length, std::vector<Command> &commands)
+  {
+    commands.clear();
+    if (data == nullptr || length < 2 || data[0] != kVersion)
+    {
+      return false;
+    }
+
+    const size_t count = data[1];
+    if (count == 0 || count > kMaxCommandsPerWrite)
+    {
+      return false;
+    }
+
+    size_t offset = 2;
+    commands.resize(count);
+    for (Command &command : commands)
+    {
+      if (length - offset < kCommandHeaderSize)
+      {
+        commands.clear();
+        return false;
+      }
+      command.sequence = data[offset];
+      command.opcode = static_cast<Opcode>(data[offset + 1]);
+      command.length = data[offset + 2];
+      offset += kCommandHeaderSize;
+
+      if (length - offset < command.length)
+      {
+        commands.clear();
+        return false;
+      }
+      memcpy(command.payload, data + offset, command.length);
+      offset += command.length;
+    }
+
+    // Trailing bytes mean the count and the lengths disagree.
+    if (offset != length)
+    {
+      commands.clear();
+      return false;
+    }
+    return true;
+  }
+
+  size_t encodeCommands(const std::vector<Command> &commands, uint8_t *buffer, size_t size)
+  {
+    if (commands.empty() || commands.size() > kMaxCommandsPerWrite || size < 2)
+    {
+      return 0;
+    }
+
+    buffer[0] = kVersion;
+    buffer[1] = static_cast<uint8_t>(commands.size());
+    size_t offset = 2;
+    for (const Command &command : commands)
+    {
+      if (size - offset < kCommandHeaderSize + command.length)
+      {
+        return 0;
+      }
+      buffer[offset] = command.sequence;
+      buffer[offset + 1] = static_cast<uint8_t>(command.opcode);
+      buffer[offset + 2] = command.length;
+      memcpy(buffer + offset + kCommandHeaderSize, command.payload, command.length);
+      offset += kCommandHeaderSize + command.length;
+    }
+    return offset;
+  }
+
+  uint16_t readUint16(const uint8_t *data)
+  {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+  }
+
+  void writeUint16(uint8_t *data, uint16_t value)
+  {
+    data[0] = static_cast<uint8_t>(value);
+    data[1] = static_cast<uint8_t>(value >> 8);
+  }
+
+  void encodeState(const State &state, uint8_t *buffer)
+  {
+    buffer[0] = kVersion;
+    buffer[1] = state.flags;
+    writeUint16(buffer + 2, state.emotionId);
+    buffer[4] = state.brightness;
+    buffer[5] = state.fanPercent;
+    writeUint16(buffer + 6, state.millivolts);
+    writeUint16(buffer + 8, static_cast<uint16_t>(state.milliamps));
+  }
+
+  bool decodeState(const uint8_t *data, size_t length, State &state)
+  {
+    if (data == nullptr || length != kStateSize || data[0] != kVersion)
+    {
+      return false;
+    }
+    state.flags = data[1];
+    state.emotionId = readUint16(data + 2);
+    state.brightness = data[4];
+    state.fanPercent = data[5];
+    state.millivolts = readUint16(data + 6);
+    state.milliamps = static_cast<int16_t>(readUint16(data + 8));
+    return true;
+  }
+
+  ResponseWriter::ResponseWriter(uint16_t mtu, SendFunction send)
+      : send_(std::move(send)),
+        maxSegmentSize_((mtu > kDefaultMtu ? mtu : kDefaultMtu) - kAttHeaderSize),
+        segmentIndex_(0),
+        truncated_(false)
+  {
+    segment_.reserve(maxSegmentSize_);
+  }
+
+  void ResponseWriter::begin(const Command &command, Status status)
+  {
+    segment_.clear();
+    segment_.push_back(kVersion);
+    segment_.push_back(command.sequence);
+    segment_.push_back(static_cast<uint8_t>(command.opcode) | kResponseFlag);
+    segment_.push_back(static_cast<uint8_t>(status));
+    segment_.push_back(0);
+    segment_.push_back(0);
+    segmentIndex_ = 0;
+    truncated_ = false;
+  }
+
+  bool ResponseWriter::addEntry(const uint8_t *data, size_t length)
+  {
+    if (truncated_ || length > getMaxEntrySize())
+    {
+      return false;
+    }
+    if (segment_.size() + length > maxSegmentSize_)
+    {
+      // The last segment number stays free for the Truncated status.
+      if (segmentIndex_ + 2u >= kMaxSegments)
+      {
+        truncated_ = true;
+        return false;
+      }
+      flush(true);
+    }
+    segment_.insert(segment_.end(), data, data + length);
+    return true;
+  }
+
+  void ResponseWriter::finish()
+  {
+    if (truncated_)
+    {
+      flush(true);
+      segment_[3] = static_cast<uint8_t>(Status::Truncated);
+    }
+    flush(false);
+  }
+
+  size_t ResponseWriter::getMaxEntrySize() const
+  {
+    return maxSegmentSize_ - kResponseHeaderSize;
+  }
+
+  void ResponseWriter::sendStatus(const Command &command, Status status)
+  {
+    begin(command, status);
+    finish();
+  }
+
+  void ResponseWriter::flush(bool more)
+  {
+    segment_[4] = segmentIndex_;
+    segment_[5] = more ? kFlagMoreSegments : 0;
+    send_(segment_.data(), segment_.size());
+
+    ++segmentIndex_;
+    segment_.resize(kResponseHeaderSize);
+  }
+}
@@ -0,0 +1,127 @@
+#ifndef BLE_PROTOCOL_HPP
+#define BLE_PROTOCOL_HPP
+
+#include <Arduino.h>
+
+#include <functional>
+#include <vector>
+
+// Binary remote protocol used on the ffe2 characteristic. Nothing in here
+// depends on NimBLE, so remotes can share the codec.
+//
+// Write (remote -> device), several commands per write:
+//   version(u8) count(u8) { sequence(u8) opcode(u8) length(u8) payload[length] } * count
+//
+// Notification (device -> remote), one or more segments per command:
+//   version(u8) sequence(u8) opcode|0x80(u8) status(u8) segment(u8) flags(u8) payload
+// A response longer than one notification is split into segments numbered from
+// 0; every segment but the last has kFlagMoreSegments set. List entries are
+// never split across segments. A response needing more than kMaxSegments ends
+// early with a last, empty segment whose status is Truncated.
+namespace BleProtocol
+{
+  constexpr uint8_t kVersion = 1;
+  constexpr size_t kMaxCommandsPerWrite = 8;
+  constexpr size_t kCommandHeaderSize = 3;
+  constexpr size_t kResponseHeaderSize = 6;
+  constexpr uint8_t kResponseFlag = 0x80;
+  constexpr uint8_t kFlagMoreSegments = 0x01;
+  // The segment number is one byte.
+  constexpr size_t kMaxSegments = 256;
+  // ATT notifications carry MTU - 3 bytes.
+  constexpr size_t kAttHeaderSize = 3;
+  constexpr size_t kDefaultMtu = 23;
+
+  enum class Opcode : uint8_t
+  {
+    // -> version(u8) emotionCount(u16) capabilityCount(u8) currentEmotionId(u16)
+    GetInfo = 0x01,
+    // -> { id(u16) nameLength(u8) name } per emotion
+    ListEmotions = 0x02,
+    // -> { index(u8) nameLength(u8) name } per capability
+    ListCapabilities = 0x03,
+    // id(u16) ->
+    SetEmotion = 0x04,
+    // index(u8) ->
+    RunCapability = 0x05,
+    // -> frame statistics summary text
+    GetStats = 0x06,
+  };
+
+  enum class Status : uint8_t
+  {
+    Ok = 0,
+    UnknownOpcode = 1,
+    InvalidPayload = 2,
+    NotFound = 3,
+    Busy = 4,
+    // The response did not fit into kMaxSegments; a larger MTU helps.
+    Truncated = 5,
+  };
+
+  struct Command
+  {
+    uint8_t sequence = 0;
+    Opcode opcode = Opcode::GetInfo;
+    uint8_t length = 0;
+    uint8_t payload[UINT8_MAX];
+  };
+
+  // All or nothing: a malformed write yields no commands.
+  bool decodeCommands(const uint8_t *data, size_t length, std::vector<Command> &commands);
+  // Counterpart of decodeCommands() for remotes; returns the bytes written or 0.
+  size_t encodeCommands(const std::vector<Command> &commands, uint8_t *buffer, size_t size);
+
+  uint16_t readUint16(const uint8_t *data);
+  void writeUint16(uint8_t *data, uint16_t value);
+
+  // Value of the ffe3 state characteristic (read and notify):
+  //   version(u8) flags(u8) emotionId(u16) brightness(u8) fanPercent(u8) millivolts(u16) milliamps(i16)
+  // millivolts and milliamps are only meaningful with kStateFlagPower set.
+  constexpr size_t kStateSize = 10;
+  constexpr uint8_t kStateFlagPower = 0x01;
+
+  struct State
+  {
+    uint8_t flags = 0;
+    uint16_t emotionId = 0;
+    uint8_t brightness = 0;
+    uint8_t fanPercent = 0;
+    uint16_t millivolts = 0;
+    int16_t milliamps = 0;
+  };
+
+  void encodeState(const State &state, uint8_t *buffer);
+  bool decodeState(const uint8_t *data, size_t length, State &state);
+
+  // Builds the segments of one response and hands each to `send`.
+  class ResponseWriter
+  {
+  public:
+    using SendFunction = std::function<void(const uint8_t *data, size_t length)>;
+
+    ResponseWriter(uint16_t mtu, SendFunction send);
+
+    void begin(const Command &command, Status status = Status::Ok);
+    // Adds an entry that must stay within one segment. False when it is too
+    // large or the response has run out of segment numbers.
+    bool addEntry(const uint8_t *data, size_t length);
+    void finish();
+    // Largest entry addEntry() accepts at the negotiated MTU.
+    size_t getMaxEntrySize() const;
+
+    // Shortcut for responses without payload.
+    void sendStatus(const Command &command, Status status);
+
+  private:
+    void flush(bool more);
+
+    SendFunction send_;
+    std::vector<uint8_t> segment_;
+    size_t maxSegmentSize_;
+    uint8_t segmentIndex_;
+    bool truncated_;
+  };
+}
+
+#endif // BLE_PROTOCOL_HPP
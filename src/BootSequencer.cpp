@@ -0,0 +1,222 @@
+#include "BootSequencer.hpp"
+
+namespace
+{
+  constexpr uint32_t kBackgroundStackSize = 8192;
+  constexpr UBaseType_t kBackgroundPriority = 1;
+  // The loop task runs on core 1; radio bring-up stays next to the Wi-Fi/BLE stacks.
+  constexpr BaseType_t kBackgroundCore = 0;
+}
+
+BootSequencer::BootSequencer(const FrameStats &frameStats)
+    : frameStats_(frameStats),
+      stageCount_(0),
+      nextLoopStage_(0),
+      setupMicros_(0),
+      firstFrameMicros_(0),
+      deferredStarted_(false)
+{
+}
+
+bool BootSequencer::run(const char *name, StageFunction stage)
+{
+  if (stageCount_ >= kMaxStages)
+  {
+    return stage();
+  }
+
+  Stage &entry = stages_[stageCount_++];
+  entry.name = name;
+  entry.mode = Mode::Setup;
+  entry.function = std::move(stage);
+  return execute(entry);
+}
+
+size_t BootSequencer::defer(const char *name, Mode mode, StageFunction stage)
+{
+  if (stageCount_ >= kMaxStages)
+  {
+    Serial.printf("[E] Boot: too many stages, running %s now.\n", name);
+    stage();
+    return kMaxStages;
+  }
+
+  Stage &entry = stages_[stageCount_];
+  entry.name = name;
+  entry.mode = mode == Mode::Setup ? Mode::Loop : mode;
+  entry.function = std::move(stage);
+  return stageCount_++;
+}
+
+void BootSequencer::finishSetup()
+{
+  setupMicros_ = micros();
+  Serial.printf("[I] Boot: setup done after %lu ms\n", static_cast<unsigned long>(setupMicros_ / 1000));
+}
+
+void BootSequencer::update()
+{
+  if (firstFrameMicros_ == 0 && frameStats_.getFrameCount() > 0)
+  {
+    firstFrameMicros_ = micros();
+    Serial.printf("[I] Boot: first face frame after %lu ms\n", static_cast<unsigned long>(getFirstFrameMillis()));
+  }
+
+  if (!deferredStarted_)
+  {
+    if (firstFrameMicros_ == 0 && micros() - setupMicros_ < kFirstFrameTimeoutMs * 1000UL)
+    {
+      return;
+    }
+    if (firstFrameMicros_ == 0)
+    {
+      Serial.println(F("[W] Boot: no face frame yet, starting deferred stages anyway."));
+    }
+    startDeferredStages();
+    return;
+  }
+
+  // One stage per loop iteration keeps the animation moving between them.
+  while (nextLoopStage_ < stageCount_)
+  {
+    Stage &stage = stages_[nextLoopStage_++];
+    if (stage.mode == Mode::Loop)
+    {
+      execute(stage);
+      return;
+    }
+  }
+}
+
+bool BootSequencer::isDone(size_t stageId) const
+{
+  return stageId < stageCount_ && stages_[stageId].done.load(std::memory_order_acquire);
+}
+
+bool BootSequencer::hasSucceeded(size_t stageId) const
+{
+  // succeeded is written before done is released, so it is safe to read here.
+  return isDone(stageId) && stages_[stageId].succeeded;
+}
+
+bool BootSequencer::isComplete() const
+{
+  for (size_t index = 0; index < stageCount_; ++index)
+  {
+    if (!isDone(index))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BootSequencer::isFirstFrameShown() const
+{
+  return firstFrameMicros_ != 0;
+}
+
+uint32_t BootSequencer::getFirstFrameMillis() const
+{
+  return firstFrameMicros_ / 1000;
+}
+
+void BootSequencer::serialize(JsonVariant json) const
+{
+  json["setupMs"] = setupMicros_ / 1000;
+  if (isFirstFrameShown())
+  {
+    json["firstFrameMs"] = getFirstFrameMillis();
+  }
+  else
+  {
+    json["firstFrameMs"] = nullptr;
+  }
+  json["complete"] = isComplete();
+
+  JsonArray stages = json["stages"].to<JsonArray>();
+  for (size_t index = 0; index < stageCount_; ++index)
+  {
+    const Stage &stage = stages_[index];
+    JsonObject entry = stages.add<JsonObject>();
+    entry["name"] = stage.name;
+    entry["mode"] = getModeName(stage.mode);
+    if (!isDone(index))
+    {
+      entry["state"] = "pending";
+      continue;
+    }
+    entry["state"] = hasSucceeded(index) ? "ok" : "failed";
+    entry["startMs"] = stage.startMicros / 1000;
+    entry["durationMs"] = stage.durationMicros / 1000.0f;
+  }
+}
+
+bool BootSequencer::execute(Stage &stage)
+{
+  stage.startMicros = micros();
+  stage.succeeded = stage.function();
+  stage.durationMicros = micros() - stage.startMicros;
+  stage.function = nullptr;
+  stage.done.store(true, std::memory_order_release);
+
+  Serial.printf("[%c] Boot: %s %s in %lu ms\n", stage.succeeded ? 'I' : 'W', stage.name,
+                stage.succeeded ? "ready" : "failed", static_cast<unsigned long>(stage.durationMicros / 1000));
+  return stage.succeeded;
+}
+
+void BootSequencer::startDeferredStages()
+{
+  deferredStarted_ = true;
+
+  bool hasBackgroundStages = false;
+  for (size_t index = 0; index < stageCount_; ++index)
+  {
+    hasBackgroundStages |= stages_[index].mode == Mode::Background && !isDone(index);
+  }
+  if (!hasBackgroundStages)
+  {
+    return;
+  }
+
+  if (xTaskCreatePinnedToCore(backgroundTask, "boot", kBackgroundStackSize, this,
+                              kBackgroundPriority, nullptr, kBackgroundCore) != pdPASS)
+  {
+    Serial.println(F("[W] Boot: could not start background task, running stages inline."));
+    for (size_t index = 0; index < stageCount_; ++index)
+    {
+      if (stages_[index].mode == Mode::Background && !isDone(index))
+      {
+        execute(stages_[index]);
+      }
+    }
+  }
+}
+
+void BootSequencer::backgroundTask(void *parameter)
+{
+  BootSequencer *sequencer = static_cast<BootSequencer *>(parameter);
+  for (size_t index = 0; index < sequencer->stageCount_; ++index)
+  {
+    Stage &stage = sequencer->stages_[index];
+    if (stage.mode == Mode::Background && !stage.done.load(std::memory_order_acquire))
+    {
+      sequencer->execute(stage);
+    }
+  }
+  vTaskDelete(nullptr);
+}
+
+const char *BootSequencer::getModeName(Mode mode)
+{
+  switch (mode)
+  {
+  case Mode::Setup:
+    return "setup";
+  case Mode::Loop:
+    return "loop";
+  case Mode::Background:
+    return "background";
+  }
+  return "unknown";
+}
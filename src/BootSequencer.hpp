@@ -0,0 +1,80 @@
+#ifndef BOOT_SEQUENCER_HPP
+#define BOOT_SEQUENCER_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <atomic>
+#include <functional>
+
+#include "FaceDisplay/FrameStats.hpp"
+
+// Runs the boot stages needed for the first face frame inside setup() and
+// holds everything else back until that frame is on screen. Deferred stages
+// either run one per update() on the loop task (anything sharing the I2C bus
+// with the loop) or in order on a background task (radio and filesystem work).
+// Every stage is timed, as is the time from reset to the first face frame.
+class BootSequencer
+{
+public:
+  enum class Mode
+  {
+    Setup,
+    Loop,
+    Background
+  };
+
+  using StageFunction = std::function<bool()>;
+
+  static constexpr size_t kMaxStages = 16;
+  // Deferred stages start anyway if no frame was drawn by then (e.g. missing GIF).
+  static constexpr uint32_t kFirstFrameTimeoutMs = 3000;
+
+  explicit BootSequencer(const FrameStats &frameStats);
+
+  // Runs a stage now, on the critical path to the first frame.
+  bool run(const char *name, StageFunction stage);
+  // Queues a stage to run once the first frame is shown. Returns its id.
+  size_t defer(const char *name, Mode mode, StageFunction stage);
+  // Marks the end of setup().
+  void finishSetup();
+  // Call from loop() right after the face display was updated.
+  void update();
+
+  // True once a stage ran, whether or not it succeeded.
+  bool isDone(size_t stageId) const;
+  // True once a stage ran and reported success.
+  bool hasSucceeded(size_t stageId) const;
+  bool isComplete() const;
+  bool isFirstFrameShown() const;
+  uint32_t getFirstFrameMillis() const;
+
+  void serialize(JsonVariant json) const;
+
+private:
+  struct Stage
+  {
+    const char *name = nullptr;
+    Mode mode = Mode::Setup;
+    StageFunction function;
+    uint32_t startMicros = 0;
+    uint32_t durationMicros = 0;
+    bool succeeded = false;
+    std::atomic<bool> done{false};
+  };
+
+  bool execute(Stage &stage);
+  void startDeferredStages();
+  static void backgroundTask(void *parameter);
+  static const char *getModeName(Mode mode);
+
+  const FrameStats &frameStats_;
+  Stage stages_[kMaxStages];
+  size_t stageCount_;
+  size_t nextLoopStage_;
+  uint32_t setupMicros_;
+  std::atomic<uint32_t> firstFrameMicros_;
+  bool deferredStarted_;
+};
+
+#endif // BOOT_SEQUENCER_HPP
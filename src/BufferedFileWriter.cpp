@@ -0,0 +1,135 @@
+#include "BufferedFileWriter.hpp"
+
+#include <esp_rom_crc.h>
+#include <string.h>
+
+BufferedFileWriter::~BufferedFileWriter()
+{
+  abort();
+}
+
+bool BufferedFileWriter::open(fs::FS &fs, const String &path)
+{
+  abort();
+
+  buffer_ = static_cast<uint8_t *>(malloc(kBufferSize));
+  if (buffer_ == nullptr)
+  {
+    return false;
+  }
+
+  file_ = fs.open(path, FILE_WRITE);
+  if (!file_)
+  {
+    releaseBuffer();
+    return false;
+  }
+
+  buffered_ = 0;
+  bytesWritten_ = 0;
+  crc_ = 0;
+  return true;
+}
+
+bool BufferedFileWriter::write(const uint8_t *data, size_t len)
+{
+  if (!file_)
+  {
+    return false;
+  }
+
+  crc_ = esp_rom_crc32_le(crc_, data, len);
+
+  while (len > 0)
+  {
+    // Whole pages bypass the buffer when nothing is pending.
+    if (buffered_ == 0 && len >= kBufferSize)
+    {
+      const size_t direct = len - (len % kBufferSize);
+      if (!writeThrough(data, direct))
+      {
+        return false;
+      }
+      data += direct;
+      len -= direct;
+      continue;
+    }
+
+    const size_t space = kBufferSize - buffered_;
+    const size_t toCopy = len < space ? len : space;
+    memcpy(buffer_ + buffered_, data, toCopy);
+    buffered_ += toCopy;
+    data += toCopy;
+    len -= toCopy;
+
+    if (buffered_ == kBufferSize && !flush())
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool BufferedFileWriter::close()
+{
+  if (!file_)
+  {
+    return false;
+  }
+
+  const bool flushed = flush();
+  file_.close();
+  releaseBuffer();
+  return flushed;
+}
+
+void BufferedFileWriter::abort()
+{
+  if (file_)
+  {
+    file_.close();
+  }
+  releaseBuffer();
+}
+
+bool BufferedFileWriter::isOpen() const
+{
+  return static_cast<bool>(file_);
+}
+
+size_t BufferedFileWriter::bytesWritten() const
+{
+  return bytesWritten_;
+}
+
+uint32_t BufferedFileWriter::crc32() const
+{
+  return crc_;
+}
+
+bool BufferedFileWriter::flush()
+{
+  if (buffered_ == 0)
+  {
+    return true;
+  }
+
+  const bool written = writeThrough(buffer_, buffered_);
+  buffered_ = 0;
+  return written;
+}
+
+bool BufferedFileWriter::writeThrough(const uint8_t *data, size_t len)
+{
+  const size_t written = file_.write(data, len);
+  bytesWritten_ += written;
+  return written == len;
+}
+
+void BufferedFileWriter::releaseBuffer()
+{
+  free(buffer_);
+  buffer_ = nullptr;
+  buffered_ = 0;
+}
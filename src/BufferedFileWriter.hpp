@@ -0,0 +1,45 @@
+#ifndef BUFFERED_FILE_WRITER_HPP
+#define BUFFERED_FILE_WRITER_HPP
+
+#include <FS.h>
+
+#include <Arduino.h>
+
+// Keeps one file open for a whole upload and coalesces incoming chunks into
+// flash-page-sized writes, so LittleFS commits metadata once per page instead
+// of once per network chunk. A running CRC-32 of everything written is kept.
+class BufferedFileWriter {
+public:
+  static constexpr size_t kBufferSize = 4096;
+
+  BufferedFileWriter() = default;
+  ~BufferedFileWriter();
+
+  BufferedFileWriter(const BufferedFileWriter &) = delete;
+  BufferedFileWriter &operator=(const BufferedFileWriter &) = delete;
+
+  bool open(fs::FS &fs, const String &path);
+  bool write(const uint8_t *data, size_t len);
+  // Flushes the remaining bytes and closes the file.
+  bool close();
+  // Closes the file without flushing; the caller removes the partial file.
+  void abort();
+
+  bool isOpen() const;
+  size_t bytesWritten() const;
+  // Standard CRC-32 (as produced by zlib / `crc32` tools) of the bytes written.
+  uint32_t crc32() const;
+
+private:
+  bool flush();
+  bool writeThrough(const uint8_t *data, size_t len);
+  void releaseBuffer();
+
+  File file_;
+  uint8_t *buffer_ = nullptr;
+  size_t buffered_ = 0;
+  size_t bytesWritten_ = 0;
+  uint32_t crc_ = 0;
+};
+
+#endif // BUFFERED_FILE_WRITER_HPP
@@ -28,6 +28,16 @@ Capability *CapabilityManager::getCapabilityByName(const String &name) const
   return nullptr;
 }
 
+Capability *CapabilityManager::getCapability(size_t index) const
+{
+  return index < capabilities_.size() ? capabilities_[index].get() : nullptr;
+}
+
+size_t CapabilityManager::getCapabilityCount() const
+{
+  return capabilities_.size();
+}
+
 std::vector<String> CapabilityManager::getAvailableCapabilities() const
 {
   std::vector<String> capabilityNames;
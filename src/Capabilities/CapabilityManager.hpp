@@ -17,6 +17,8 @@ public:
                     std::function<void()> onSettingsChanged);
 
   Capability *getCapabilityByName(const String &name) const;
+  Capability *getCapability(size_t index) const;
+  size_t getCapabilityCount() const;
   std::vector<String> getAvailableCapabilities() const;
 
 private:
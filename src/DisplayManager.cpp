@@ -3,18 +3,12 @@
 #include <WiFi.h>
 #include <Wire.h>
 
+#include "HeapMonitor.hpp"
+
 namespace {
 constexpr uint8_t kDisplayAddress = 0x3C;
 constexpr uint8_t kRotation = 2;
-
-String FormatHex(uint8_t value) {
-  String text = String(value, HEX);
-  if (text.length() < 2) {
-    text = "0" + text;
-  }
-  text.toUpperCase();
-  return text;
-}
+constexpr unsigned long kStatusRefreshIntervalMs = 1000;
 
 const uint8_t FAN_ICON_12X12[] PROGMEM = {
   0x7f, 0xe0, 0xa1, 0x50, 0xe3, 0x30, 0xb6, 0x10, 
@@ -42,17 +36,22 @@ const unsigned char POWER_ICON_12X12 [] PROGMEM = {
 } // namespace
 
 DisplayManager::DisplayManager(uint8_t sdaPin, uint8_t sclPin,
-                               EmotionState &emotionState,
+                               const StateStore &stateStore,
                                FanController &fanController,
                                LedBrightnessController &brightnessController,
                                SystemPowerController &systemPowerController)
     : sdaPin_(sdaPin),
       sclPin_(sclPin),
-      emotionState_(emotionState),
+      stateStore_(stateStore),
       fanController_(fanController),
       brightnessController_(brightnessController),
       systemPowerController_(systemPowerController),
-      display_() {}
+      display_(),
+      emotionLine_(),
+      fanLine_(),
+      earLine_(),
+      statusLine_(),
+      lastStatusRefreshMillis_(0) {}
 
 void DisplayManager::begin() {
   Wire.begin(sdaPin_, sclPin_);
@@ -66,6 +65,30 @@ void DisplayManager::begin() {
 }
 
 void DisplayManager::update() {
+  HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Display);
+
+  // Lines are formatted into fixed buffers; the OLED is only redrawn when one of them changed.
+  bool changed = false;
+  // Read from the published snapshot, so a web or BLE edit never stalls the loop here.
+  StateStore::Snapshot state;
+  stateStore_.read(state);
+  changed |= updateLine(emotionLine_, sizeof(emotionLine_), state.emotionName);
+
+  char text[kLineLength];
+  formatFanInfo(text, sizeof(text));
+  changed |= updateLine(fanLine_, sizeof(fanLine_), text);
+
+  formatEarInfo(text, sizeof(text));
+  changed |= updateLine(earLine_, sizeof(earLine_), text);
+
+  if (formatStatusInfo(text, sizeof(text))) {
+    changed |= updateLine(statusLine_, sizeof(statusLine_), text);
+  }
+
+  if (!changed) {
+    return;
+  }
+
   renderStatus();
   display_.display();
 }
@@ -78,23 +101,18 @@ void DisplayManager::renderStatus() {
   display_.setCursor(0, 0);
 
   display_.setTextSize(2);
-  display_.println(emotionState_.getDisplayEmotion());
+  display_.println(emotionLine_);
   
   display_.setTextSize(1);
-  DrawIconLine(FAN_ICON_12X12, firstLineHeight, formatFanInfo());
-  DrawIconLine(BRIGHTNESS_ICON_12X12, firstLineHeight+lineHeight, formatEarInfo());
+  DrawIconLine(FAN_ICON_12X12, firstLineHeight, fanLine_);
+  DrawIconLine(BRIGHTNESS_ICON_12X12, firstLineHeight+lineHeight, earLine_);
 
   uint8_t statusLine = 2;
-  if (systemPowerController_.isEnabled()) {
-    DrawIconLine(POWER_ICON_12X12, firstLineHeight + statusLine * lineHeight, formatSystemPowerInfo());
-  }
-  else {     
-    IPAddress ip = WiFi.softAPIP();
-    DrawIconLine(WIFI_ICON_12X12, firstLineHeight + statusLine * lineHeight, ip.toString());
-  }
+  const uint8_t *statusIcon = systemPowerController_.isEnabled() ? POWER_ICON_12X12 : WIFI_ICON_12X12;
+  DrawIconLine(statusIcon, firstLineHeight + statusLine * lineHeight, statusLine_);
 }
 
-void DisplayManager::DrawIconLine(const uint8_t* icon, uint8_t offsetTop, String text){
+void DisplayManager::DrawIconLine(const uint8_t* icon, uint8_t offsetTop, const char *text){
   const uint8_t lineOffsetPx = 2;
   const uint8_t iconSize = 12;
   const uint8_t textOffsetLeft = 20;
@@ -104,20 +122,35 @@ void DisplayManager::DrawIconLine(const uint8_t* icon, uint8_t offsetTop, String
   display_.print(text);
 }
 
-String DisplayManager::formatEarInfo() const {
-  String line = F("");
-  line += String(static_cast<int>(brightnessController_.getBrightnessPercent() + 0.5f));
-  line += F("%");
-  return line;
+bool DisplayManager::updateLine(char *line, size_t size, const char *text) {
+  if (strncmp(line, text, size) == 0) {
+    return false;
+  }
+  strlcpy(line, text, size);
+  return true;
+}
+
+void DisplayManager::formatEarInfo(char *buffer, size_t size) const {
+  snprintf(buffer, size, "%d%%", static_cast<int>(brightnessController_.getBrightnessPercent() + 0.5f));
 }
 
-String DisplayManager::formatFanInfo() const {
-  String line = F("");
-  line += String(static_cast<int>(fanController_.getDutyCyclePercent()));
-  line += F("%");
-  return line;
+void DisplayManager::formatFanInfo(char *buffer, size_t size) const {
+  snprintf(buffer, size, "%d%%", static_cast<int>(fanController_.getDutyCyclePercent()));
 }
 
-String DisplayManager::formatSystemPowerInfo() {
-  return systemPowerController_.readPowerInfo();
+bool DisplayManager::formatStatusInfo(char *buffer, size_t size) {
+  const unsigned long now = millis();
+  if (statusLine_[0] != '\0' && now - lastStatusRefreshMillis_ < kStatusRefreshIntervalMs) {
+    return false;
+  }
+  lastStatusRefreshMillis_ = now;
+
+  if (systemPowerController_.isEnabled()) {
+    systemPowerController_.formatPowerInfo(buffer, size);
+    return true;
+  }
+
+  const IPAddress ip = WiFi.softAPIP();
+  snprintf(buffer, size, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  return true;
 }
@@ -6,13 +6,13 @@
 #include <Arduino.h>
 
 #include "LedBrightnessController.hpp"
-#include "EmotionState.hpp"
+#include "StateStore.hpp"
 #include "FanController.hpp"
 #include "SystemPowerController.hpp"
 
 class DisplayManager {
 public:
-  DisplayManager(uint8_t sdaPin, uint8_t sclPin, EmotionState &emotionState,
+  DisplayManager(uint8_t sdaPin, uint8_t sclPin, const StateStore &stateStore,
                  FanController &fanController, LedBrightnessController &brightnessController,
                  SystemPowerController &systemPowerController);
 
@@ -20,19 +20,26 @@ public:
   void update();
 
 private:
+    static constexpr size_t kLineLength = 24;
+
     void renderStatus();
-    void DrawIconLine(const uint8_t lineOffsetPx, const uint8_t iconSize, const uint8_t textOffsetLeft);
-    String formatEarInfo() const;
-    String formatFanInfo() const;
-    String formatSystemPowerInfo();
-    void DrawIconLine(const uint8_t* icon, uint8_t offsetTop, String text);
+    bool updateLine(char *line, size_t size, const char *text);
+    void formatEarInfo(char *buffer, size_t size) const;
+    void formatFanInfo(char *buffer, size_t size) const;
+    bool formatStatusInfo(char *buffer, size_t size);
+    void DrawIconLine(const uint8_t* icon, uint8_t offsetTop, const char *text);
     uint8_t sdaPin_;
     uint8_t sclPin_;
-    EmotionState &emotionState_;
+    const StateStore &stateStore_;
     FanController &fanController_;
     LedBrightnessController &brightnessController_;
     SystemPowerController &systemPowerController_;
     Adafruit_SH1106 display_;
+    char emotionLine_[kLineLength];
+    char fanLine_[kLineLength];
+    char earLine_[kLineLength];
+    char statusLine_[kLineLength];
+    unsigned long lastStatusRefreshMillis_;
 };
 
 #endif // DISPLAY_MANAGER_HPP
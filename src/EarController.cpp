@@ -1,5 +1,7 @@
 #include "EarController.hpp"
 
+#include "HeapMonitor.hpp"
+
 EarController::EarController(uint16_t ledCount, uint8_t dataPin, LedBrightnessController &brightnessController)
     : ledCount_(ledCount),
       earLeds_(ledCount, dataPin, NEO_GRB + NEO_KHZ800),
@@ -19,6 +21,7 @@ void EarController::setGradient(Gradient gradient) { ear_.setGradient(gradient);
 Ear &EarController::getEar() { return ear_; }
 
 void EarController::update() {
+  HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Ears);
   earLeds_.setBrightness(brightnessController_.getBrightness());
   if (ear_.getColorMode() == ColorMode::Gradient) {
     const auto &gradient = ear_.getGradient();
@@ -1,10 +1,14 @@
 #include "EmotionState.hpp"
 
-EmotionState::EmotionState()
-    : currentEmotion_("/anims/neutral.gif"),
+EmotionState::EmotionState(StateStore &stateStore)
+    : stateStore_(stateStore),
+      currentEmotion_("/anims/neutral.gif"),
       previousEmotion_("/anims/neutral.gif"),
       tiltUpEmotion_("/anims/happy.gif"),
-      tiltSideEmotion_("/anims/confused.gif")
+      tiltSideEmotion_("/anims/confused.gif"),
+      nextId_(1),
+      currentRevision_(0),
+      currentIndex_(-1)
 {
   seedEmotionDefinitions({
       EmotionDefinition("Blush", "/anims/blush.gif", Color(0, 0, 0), Gradient(Color(0, 0, 0), Color(255, 192, 203), 0.0f, 0.5f), ColorMode::Gradient),
@@ -16,14 +20,14 @@ EmotionState::EmotionState()
   });
 }
 
-const String EmotionState::getDisplayEmotion() const
+std::unique_lock<std::recursive_mutex> EmotionState::lock() const
 {
-  const EmotionDefinition *emotion = getCurrentEmotionDefinition();
-  if (emotion != nullptr && emotion->name.length())
-  {
-    return emotion->name;
-  }
-  return FileHelper::GetNameOnly(currentEmotion_);
+  return std::unique_lock<std::recursive_mutex>(mutex_);
+}
+
+std::unique_lock<std::recursive_mutex> EmotionState::tryLock() const
+{
+  return std::unique_lock<std::recursive_mutex>(mutex_, std::try_to_lock);
 }
 
 const String &EmotionState::getCurrentEmotion() const
@@ -38,23 +42,42 @@ const String &EmotionState::getPreviousEmotion() const
 
 void EmotionState::setCurrentEmotion(const String &emotionName)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   previousEmotion_ = currentEmotion_;
 
-  const EmotionDefinition *byName = getEmotionDefinitionByName(emotionName);
-  if (byName != nullptr)
+  int index = findEmotionIndexByName(emotionName);
+  if (index < 0)
   {
-    currentEmotion_ = byName->path;
-    return;
+    index = findEmotionIndexByPath(emotionName);
   }
+  currentIndex_ = index;
+  setCurrentPath(index >= 0 ? emotionDefinitions_[static_cast<size_t>(index)].path : emotionName);
+}
 
-  const EmotionDefinition *byPath = getEmotionDefinitionByPath(emotionName);
-  if (byPath != nullptr)
+bool EmotionState::setCurrentEmotionById(uint16_t id)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  const int index = findEmotionIndexById(id);
+  if (index < 0)
   {
-    currentEmotion_ = byPath->path;
-    return;
+    return false;
   }
 
-  currentEmotion_ = emotionName;
+  previousEmotion_ = currentEmotion_;
+  currentIndex_ = index;
+  setCurrentPath(emotionDefinitions_[static_cast<size_t>(index)].path);
+  return true;
+}
+
+uint16_t EmotionState::getCurrentEmotionId() const
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return currentIndex_ >= 0 ? emotionDefinitions_[static_cast<size_t>(currentIndex_)].id : 0;
+}
+
+uint32_t EmotionState::getCurrentEmotionRevision() const
+{
+  return currentRevision_;
 }
 
 const String &EmotionState::getTiltUpEmotion() const
@@ -67,13 +90,27 @@ const String &EmotionState::getTiltSideEmotion() const
   return tiltSideEmotion_;
 }
 
+void EmotionState::showTiltUpEmotion()
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  setCurrentEmotion(tiltUpEmotion_);
+}
+
+void EmotionState::showTiltSideEmotion()
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  setCurrentEmotion(tiltSideEmotion_);
+}
+
 void EmotionState::setTiltUpEmotion(const String &emotionName)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   tiltUpEmotion_ = emotionName;
 }
 
 void EmotionState::setTiltSideEmotion(const String &emotionName)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   tiltSideEmotion_ = emotionName;
 }
 
@@ -102,87 +139,210 @@ const EmotionDefinition *EmotionState::getEmotionDefinitionByPath(const String &
   return &emotionDefinitions_[static_cast<size_t>(index)];
 }
 
+const EmotionDefinition *EmotionState::getEmotionDefinitionById(uint16_t id) const
+{
+  const int index = findEmotionIndexById(id);
+  if (index < 0)
+  {
+    return nullptr;
+  }
+  return &emotionDefinitions_[static_cast<size_t>(index)];
+}
+
 const EmotionDefinition *EmotionState::getCurrentEmotionDefinition() const
 {
-  return getEmotionDefinitionByPath(currentEmotion_);
+  return currentIndex_ >= 0 ? &emotionDefinitions_[static_cast<size_t>(currentIndex_)] : nullptr;
 }
 
 bool EmotionState::upsertEmotionDefinition(const EmotionDefinition &emotion, bool overwriteExisting)
 {
-  const int nameIndex = findEmotionIndexByName(emotion.name);
-  if (nameIndex >= 0)
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  int index = findEmotionIndexByName(emotion.name);
+  if (index < 0)
   {
-    if (!overwriteExisting)
-    {
-      return false;
-    }
-    emotionDefinitions_[static_cast<size_t>(nameIndex)] = emotion;
-    return true;
+    index = findEmotionIndexByPath(emotion.path);
   }
 
-  const int pathIndex = findEmotionIndexByPath(emotion.path);
-  if (pathIndex >= 0)
+  if (index >= 0)
   {
     if (!overwriteExisting)
     {
       return false;
     }
-    emotionDefinitions_[static_cast<size_t>(pathIndex)] = emotion;
-    return true;
+    // Keep showing the edited emotion even if its path changed.
+    if (index == currentIndex_)
+    {
+      setCurrentPath(emotion.path);
+    }
+    EmotionDefinition &existing = emotionDefinitions_[static_cast<size_t>(index)];
+    const uint16_t id = existing.id;
+    existing = emotion;
+    existing.id = id;
+  }
+  else
+  {
+    emotionDefinitions_.push_back(emotion);
+    emotionDefinitions_.back().id = allocateId();
   }
 
-  emotionDefinitions_.push_back(emotion);
+  rebuildIndexes();
   return true;
 }
 
 bool EmotionState::removeEmotionDefinitionByName(const String &name)
 {
-  const int index = findEmotionIndexByName(name);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return removeEmotionDefinitionAt(findEmotionIndexByName(name));
+}
+
+bool EmotionState::removeEmotionDefinitionById(uint16_t id)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return removeEmotionDefinitionAt(findEmotionIndexById(id));
+}
+
+bool EmotionState::removeEmotionDefinitionAt(int index)
+{
   if (index < 0)
   {
     return false;
   }
 
-  const String removedPath = emotionDefinitions_[static_cast<size_t>(index)].path;
-  emotionDefinitions_.erase(emotionDefinitions_.begin() + index);
-
-  if (currentEmotion_ == removedPath)
+  if (index == currentIndex_)
   {
-    currentEmotion_ = previousEmotion_;
+    setCurrentPath(previousEmotion_);
   }
+  emotionDefinitions_.erase(emotionDefinitions_.begin() + index);
 
+  rebuildIndexes();
   return true;
 }
 
 void EmotionState::seedEmotionDefinitions(const std::vector<EmotionDefinition> &emotions)
 {
-  emotionDefinitions_.clear();
-  for (const auto &emotion : emotions)
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  emotionDefinitions_ = emotions;
+
+  // Persisted ids are kept; missing or duplicate ones get fresh ids.
+  nextId_ = 1;
+  for (const auto &emotion : emotionDefinitions_)
   {
-    emotionDefinitions_.push_back(emotion);
+    if (emotion.id >= nextId_ && emotion.id < UINT16_MAX)
+    {
+      nextId_ = emotion.id + 1;
+    }
+  }
+  idIndex_.clear();
+  for (auto &emotion : emotionDefinitions_)
+  {
+    if (emotion.id == 0 || idIndex_.count(emotion.id) > 0)
+    {
+      emotion.id = allocateId();
+    }
+    idIndex_.emplace(emotion.id, 0);
+  }
+
+  rebuildIndexes();
+}
+
+size_t EmotionState::StringHash::operator()(const String &value) const
+{
+  // FNV-1a; emotion names and paths are short.
+  uint32_t hash = 2166136261u;
+  for (size_t index = 0; index < value.length(); ++index)
+  {
+    hash ^= static_cast<uint8_t>(value[index]);
+    hash *= 16777619u;
   }
+  return hash;
 }
 
 int EmotionState::findEmotionIndexByName(const String &name) const
 {
-  for (size_t index = 0; index < emotionDefinitions_.size(); ++index)
+  const auto found = nameIndex_.find(name);
+  return found != nameIndex_.end() ? static_cast<int>(found->second) : -1;
+}
+
+int EmotionState::findEmotionIndexByPath(const String &path) const
+{
+  const auto found = pathIndex_.find(path);
+  return found != pathIndex_.end() ? static_cast<int>(found->second) : -1;
+}
+
+int EmotionState::findEmotionIndexById(uint16_t id) const
+{
+  const auto found = idIndex_.find(id);
+  return found != idIndex_.end() ? static_cast<int>(found->second) : -1;
+}
+
+uint16_t EmotionState::allocateId()
+{
+  // Ids count upwards, so a client still holding the id of a deleted emotion
+  // does not end up selecting the next one created.
+  for (uint32_t attempt = 0; attempt < UINT16_MAX; ++attempt)
   {
-    if (emotionDefinitions_[index].name == name)
+    const uint16_t id = nextId_;
+    nextId_ = nextId_ == UINT16_MAX ? 1 : nextId_ + 1;
+    if (idIndex_.count(id) == 0)
     {
-      return static_cast<int>(index);
+      idIndex_.emplace(id, 0);
+      return id;
     }
   }
-  return -1;
+  return 0;
 }
 
-int EmotionState::findEmotionIndexByPath(const String &path) const
+void EmotionState::setCurrentPath(const String &path)
+{
+  // The display name follows currentIndex_, which may change without the path.
+  const String previousDisplayEmotion = displayEmotion_;
+  const bool pathChanged = currentEmotion_ != path;
+  if (pathChanged)
+  {
+    currentEmotion_ = path;
+    ++currentRevision_;
+  }
+  refreshDisplayEmotion();
+  if (pathChanged || displayEmotion_ != previousDisplayEmotion)
+  {
+    publishCurrentEmotion();
+  }
+}
+
+void EmotionState::publishCurrentEmotion()
+{
+  stateStore_.publishEmotion(currentRevision_, getCurrentEmotionId(), currentEmotion_, displayEmotion_);
+}
+
+void EmotionState::rebuildIndexes()
 {
+  nameIndex_.clear();
+  pathIndex_.clear();
+  idIndex_.clear();
   for (size_t index = 0; index < emotionDefinitions_.size(); ++index)
   {
-    if (emotionDefinitions_[index].path == path)
-    {
-      return static_cast<int>(index);
-    }
+    // emplace keeps the first entry, matching the old front-to-back scan.
+    nameIndex_.emplace(emotionDefinitions_[index].name, index);
+    pathIndex_.emplace(emotionDefinitions_[index].path, index);
+    idIndex_.emplace(emotionDefinitions_[index].id, index);
   }
-  return -1;
+  refreshCurrentEmotion();
 }
+
+void EmotionState::refreshCurrentEmotion()
+{
+  currentIndex_ = findEmotionIndexByPath(currentEmotion_);
+  refreshDisplayEmotion();
+  publishCurrentEmotion();
+}
+
+void EmotionState::refreshDisplayEmotion()
+{
+  const EmotionDefinition *emotion = getCurrentEmotionDefinition();
+  if (emotion != nullptr && emotion->name.length())
+  {
+    displayEmotion_ = emotion->name;
+    return;
+  }
+  displayEmotion_ = FileHelper::GetNameOnly(currentEmotion_);
+}
\ No newline at end of file
@@ -3,23 +3,42 @@
 
 #include <Arduino.h>
 
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "float_helper.hpp"
 #include "Model/EmotionDefinition.hpp"
+#include "StateStore.hpp"
 
+// Written from the loop, the web server task and BLE. The setters lock
+// internally; anything that reads through a returned reference or pointer
+// has to hold lock() for as long as it uses it.
 class EmotionState {
 public:
-  EmotionState();
+  explicit EmotionState(StateStore &stateStore);
+
+  std::unique_lock<std::recursive_mutex> lock() const;
+  // Does not wait; check owns_lock().
+  std::unique_lock<std::recursive_mutex> tryLock() const;
 
   const String &getCurrentEmotion() const;
   const String &getPreviousEmotion() const;
-  const String getDisplayEmotion() const;
 
   void setCurrentEmotion(const String &emotionName);
+  bool setCurrentEmotionById(uint16_t id);
+  // 0 when the current emotion is a plain path without a definition.
+  uint16_t getCurrentEmotionId() const;
+  // Changes whenever the current emotion path changes, so per-frame checks
+  // are an integer compare and the path is only read on a switch.
+  uint32_t getCurrentEmotionRevision() const;
 
   const String &getTiltUpEmotion() const;
   const String &getTiltSideEmotion() const;
+  // Switch to the configured tilt emotion; both lock internally.
+  void showTiltUpEmotion();
+  void showTiltSideEmotion();
 
   void setTiltUpEmotion(const String &emotionName);
   void setTiltSideEmotion(const String &emotionName);
@@ -27,20 +46,49 @@ public:
   const std::vector<EmotionDefinition> &getEmotionDefinitions() const;
   const EmotionDefinition *getEmotionDefinitionByName(const String &name) const;
   const EmotionDefinition *getEmotionDefinitionByPath(const String &path) const;
+  const EmotionDefinition *getEmotionDefinitionById(uint16_t id) const;
   const EmotionDefinition *getCurrentEmotionDefinition() const;
   bool upsertEmotionDefinition(const EmotionDefinition &emotion, bool overwriteExisting);
   bool removeEmotionDefinitionByName(const String &name);
+  bool removeEmotionDefinitionById(uint16_t id);
   void seedEmotionDefinitions(const std::vector<EmotionDefinition> &emotions);
 
 private:
+  struct StringHash
+  {
+    size_t operator()(const String &value) const;
+  };
+  using EmotionIndex = std::unordered_map<String, size_t, StringHash>;
+
   int findEmotionIndexByName(const String &name) const;
   int findEmotionIndexByPath(const String &path) const;
+  int findEmotionIndexById(uint16_t id) const;
+  bool removeEmotionDefinitionAt(int index);
+  uint16_t allocateId();
+  void setCurrentPath(const String &path);
+  // Hands the current emotion to the state store for lock-free readers.
+  void publishCurrentEmotion();
+  // Rebuilds the name/path indexes and re-resolves the current emotion after
+  // the definitions changed shape (insert, remove, reseed).
+  void rebuildIndexes();
+  void refreshCurrentEmotion();
+  void refreshDisplayEmotion();
 
+  StateStore &stateStore_;
   String currentEmotion_;
   String previousEmotion_;
   String tiltUpEmotion_;
   String tiltSideEmotion_;
+  String displayEmotion_;
   std::vector<EmotionDefinition> emotionDefinitions_;
+  EmotionIndex nameIndex_;
+  EmotionIndex pathIndex_;
+  std::unordered_map<uint16_t, size_t> idIndex_;
+  uint16_t nextId_;
+  std::atomic<uint32_t> currentRevision_;
+  // Index of the definition whose path is currentEmotion_, or -1.
+  int currentIndex_;
+  mutable std::recursive_mutex mutex_;
 };
 
 #endif // EMOTION_STATE_HPP
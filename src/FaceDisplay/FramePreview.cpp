@@ -0,0 +1,167 @@
+#include "FramePreview.hpp"
+
+FramePreview::FramePreview()
+    : width_(0),
+      height_(0),
+      active_(false),
+      framebuffer_(nullptr),
+      encoded_(nullptr),
+      encodedCapacity_(0),
+      encodedLength_(0),
+      frameReady_(false),
+      lastEncodeMillis_(0),
+      encodedFrameCount_(0)
+{
+}
+
+FramePreview::~FramePreview()
+{
+  release();
+}
+
+void FramePreview::setCanvasSize(uint16_t width, uint16_t height)
+{
+  if (width == width_ && height == height_)
+  {
+    return;
+  }
+
+  release();
+  width_ = width;
+  height_ = height;
+  if (active_)
+  {
+    allocate();
+  }
+}
+
+void FramePreview::setActive(bool active)
+{
+  if (active == active_)
+  {
+    return;
+  }
+
+  active_ = active;
+  if (active_)
+  {
+    allocate();
+  }
+  else
+  {
+    release();
+  }
+}
+
+bool FramePreview::isActive() const
+{
+  return active_;
+}
+
+void FramePreview::frameCompleted()
+{
+  if (framebuffer_ == nullptr || frameReady_)
+  {
+    return;
+  }
+
+  const uint32_t now = millis();
+  if (encodedFrameCount_ > 0 && now - lastEncodeMillis_ < 1000UL / kMaxFps)
+  {
+    return;
+  }
+
+  lastEncodeMillis_ = now;
+  encodedLength_ = encode();
+  frameReady_ = encodedLength_ > 0;
+  ++encodedFrameCount_;
+}
+
+bool FramePreview::peekFrame(const uint8_t *&data, size_t &length) const
+{
+  if (!frameReady_)
+  {
+    return false;
+  }
+
+  data = encoded_;
+  length = encodedLength_;
+  return true;
+}
+
+void FramePreview::releaseFrame()
+{
+  frameReady_ = false;
+}
+
+uint32_t FramePreview::getEncodedFrameCount() const
+{
+  return encodedFrameCount_;
+}
+
+size_t FramePreview::getLastFrameBytes() const
+{
+  return encodedLength_;
+}
+
+bool FramePreview::allocate()
+{
+  const size_t pixelCount = static_cast<size_t>(width_) * height_;
+  if (pixelCount == 0)
+  {
+    return false;
+  }
+
+  // Worst case is one run per pixel.
+  encodedCapacity_ = kHeaderBytes + pixelCount * 3;
+  framebuffer_ = static_cast<uint16_t *>(calloc(pixelCount, sizeof(uint16_t)));
+  encoded_ = static_cast<uint8_t *>(malloc(encodedCapacity_));
+  if (framebuffer_ == nullptr || encoded_ == nullptr)
+  {
+    Serial.println(F("[W] Not enough heap for the face preview"));
+    release();
+    return false;
+  }
+  return true;
+}
+
+void FramePreview::release()
+{
+  free(framebuffer_);
+  free(encoded_);
+  framebuffer_ = nullptr;
+  encoded_ = nullptr;
+  encodedCapacity_ = 0;
+  encodedLength_ = 0;
+  frameReady_ = false;
+}
+
+size_t FramePreview::encode()
+{
+  uint8_t *out = encoded_;
+  *out++ = 'F';
+  *out++ = kFormatVersion;
+  *out++ = static_cast<uint8_t>(width_ & 0xFF);
+  *out++ = static_cast<uint8_t>(width_ >> 8);
+  *out++ = static_cast<uint8_t>(height_ & 0xFF);
+  *out++ = static_cast<uint8_t>(height_ >> 8);
+
+  const size_t pixelCount = static_cast<size_t>(width_) * height_;
+  size_t index = 0;
+  while (index < pixelCount)
+  {
+    const uint16_t color = framebuffer_[index];
+    uint8_t run = 1;
+    while (index + run < pixelCount && run < 255 && framebuffer_[index + run] == color)
+    {
+      ++run;
+    }
+
+    *out++ = run;
+    *out++ = static_cast<uint8_t>(color & 0xFF);
+    *out++ = static_cast<uint8_t>(color >> 8);
+    index += run;
+  }
+
+  return static_cast<size_t>(out - encoded_);
+}
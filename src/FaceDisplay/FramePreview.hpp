@@ -0,0 +1,61 @@
+#ifndef FRAME_PREVIEW_HPP
+#define FRAME_PREVIEW_HPP
+
+#include <Arduino.h>
+
+// Shadow copy of the face canvas for the remote preview. It only holds memory
+// while a preview client is connected. Finished frames are RLE-encoded at most
+// kMaxFps times per second, and only when the previous frame was taken, so a
+// slow client never holds up the panel output.
+//
+// Frame layout (little endian): 'F', version, width u16, height u16, then runs
+// of [count u8 (1..255), color rgb565 u16] covering the canvas row by row.
+class FramePreview
+{
+public:
+  static constexpr uint8_t kFormatVersion = 1;
+  static constexpr uint32_t kMaxFps = 10;
+  static constexpr size_t kHeaderBytes = 6;
+
+  FramePreview();
+  ~FramePreview();
+
+  void setCanvasSize(uint16_t width, uint16_t height);
+  void setActive(bool active);
+  bool isActive() const;
+
+  inline void setPixel(int x, int y, uint16_t color565)
+  {
+    if (framebuffer_ != nullptr && x >= 0 && y >= 0 && x < width_ && y < height_)
+    {
+      framebuffer_[y * width_ + x] = color565;
+    }
+  }
+
+  void frameCompleted();
+
+  // The encoded frame stays valid until releaseFrame().
+  bool peekFrame(const uint8_t *&data, size_t &length) const;
+  void releaseFrame();
+
+  uint32_t getEncodedFrameCount() const;
+  size_t getLastFrameBytes() const;
+
+private:
+  bool allocate();
+  void release();
+  size_t encode();
+
+  uint16_t width_;
+  uint16_t height_;
+  bool active_;
+  uint16_t *framebuffer_;
+  uint8_t *encoded_;
+  size_t encodedCapacity_;
+  size_t encodedLength_;
+  bool frameReady_;
+  uint32_t lastEncodeMillis_;
+  uint32_t encodedFrameCount_;
+};
+
+#endif // FRAME_PREVIEW_HPP
@@ -0,0 +1,269 @@
+#include "FrameStats.hpp"
+
+namespace
+{
+const uint32_t kBucketUpperBoundsMicros[FrameTimeHistogram::kBucketCount - 1] = {
+    500, 1000, 2000, 4000, 8000, 16000, 33000, 50000, 66000, 100000, 200000};
+
+float averageRate(uint64_t sum, uint32_t count, float scale)
+{
+  if (sum == 0 || count == 0)
+  {
+    return 0.0f;
+  }
+  return (scale * static_cast<float>(count)) / static_cast<float>(sum);
+}
+
+// Counters have a single writer (the render loop), so a plain load/store
+// pair is enough and avoids a locked read-modify-write per frame.
+template <typename T>
+void add(std::atomic<T> &counter, T amount)
+{
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+} // namespace
+
+FrameTimeHistogram::FrameTimeHistogram()
+{
+  reset();
+}
+
+void FrameTimeHistogram::record(uint32_t durationMicros)
+{
+  size_t bucket = 0;
+  while (bucket < kBucketCount - 1 && durationMicros > kBucketUpperBoundsMicros[bucket])
+  {
+    ++bucket;
+  }
+
+  add<uint32_t>(buckets_[bucket], 1);
+  add<uint32_t>(count_, 1);
+  add<uint64_t>(sumMicros_, durationMicros);
+
+  if (durationMicros < minMicros_.load(std::memory_order_relaxed))
+  {
+    minMicros_.store(durationMicros, std::memory_order_relaxed);
+  }
+  if (durationMicros > maxMicros_.load(std::memory_order_relaxed))
+  {
+    maxMicros_.store(durationMicros, std::memory_order_relaxed);
+  }
+}
+
+void FrameTimeHistogram::reset()
+{
+  for (size_t index = 0; index < kBucketCount; ++index)
+  {
+    buckets_[index].store(0, std::memory_order_relaxed);
+  }
+  count_ = 0;
+  minMicros_ = UINT32_MAX;
+  maxMicros_ = 0;
+  sumMicros_ = 0;
+}
+
+uint32_t FrameTimeHistogram::getCount() const
+{
+  return count_;
+}
+
+uint32_t FrameTimeHistogram::getMinMicros() const
+{
+  return count_ > 0 ? minMicros_.load() : 0;
+}
+
+uint32_t FrameTimeHistogram::getMaxMicros() const
+{
+  return maxMicros_;
+}
+
+uint32_t FrameTimeHistogram::getAverageMicros() const
+{
+  const uint32_t count = count_;
+  return count > 0 ? static_cast<uint32_t>(sumMicros_ / count) : 0;
+}
+
+uint32_t FrameTimeHistogram::getBucket(size_t index) const
+{
+  return index < kBucketCount ? buckets_[index].load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t FrameTimeHistogram::getSumMicros() const
+{
+  return sumMicros_;
+}
+
+uint32_t FrameTimeHistogram::getBucketUpperBoundMicros(size_t index)
+{
+  return index < kBucketCount - 1 ? kBucketUpperBoundsMicros[index] : 0;
+}
+
+void FrameTimeHistogram::serialize(JsonVariant json) const
+{
+  if (json.isNull())
+  {
+    return;
+  }
+
+  json["count"] = getCount();
+  json["minUs"] = getMinMicros();
+  json["maxUs"] = getMaxMicros();
+  json["avgUs"] = getAverageMicros();
+
+  JsonArray buckets = json["buckets"].to<JsonArray>();
+  for (size_t index = 0; index < kBucketCount; ++index)
+  {
+    buckets.add(getBucket(index));
+  }
+}
+
+FrameStats::FrameStats()
+    : frameCount_(0),
+      droppedFrames_(0),
+      requestedDelaySumMs_(0),
+      requestedDelayCount_(0),
+      lastFrameStartMicros_(0),
+      lastRequestedDelayMs_(0),
+      hasLastFrame_(false),
+      resetRequested_(false)
+{
+}
+
+void FrameStats::recordFrame(uint32_t frameStartMicros, uint32_t decodeMicros, uint32_t drawMicros,
+                             uint32_t presentMicros, uint32_t requestedDelayMs)
+{
+  if (resetRequested_.exchange(false))
+  {
+    reset();
+  }
+
+  decode_.record(decodeMicros);
+  draw_.record(drawMicros);
+  present_.record(presentMicros);
+  add<uint32_t>(frameCount_, 1);
+
+  if (requestedDelayMs > 0)
+  {
+    add<uint64_t>(requestedDelaySumMs_, requestedDelayMs);
+    add<uint32_t>(requestedDelayCount_, 1);
+  }
+
+  if (hasLastFrame_)
+  {
+    const uint32_t intervalMicros = frameStartMicros - lastFrameStartMicros_;
+    interval_.record(intervalMicros);
+
+    // A frame counts as dropped for every full requested delay the interval overshot by.
+    const uint32_t requestedMicros = lastRequestedDelayMs_ * 1000UL;
+    if (requestedMicros > 0 && intervalMicros > requestedMicros + requestedMicros / 2)
+    {
+      add<uint32_t>(droppedFrames_, (intervalMicros + requestedMicros / 2) / requestedMicros - 1);
+    }
+  }
+
+  lastFrameStartMicros_ = frameStartMicros;
+  lastRequestedDelayMs_ = requestedDelayMs;
+  hasLastFrame_ = true;
+}
+
+void FrameStats::restartTimeline()
+{
+  hasLastFrame_ = false;
+}
+
+void FrameStats::requestReset()
+{
+  resetRequested_ = true;
+}
+
+uint32_t FrameStats::getFrameCount() const
+{
+  return frameCount_;
+}
+
+uint32_t FrameStats::getDroppedFrames() const
+{
+  return droppedFrames_;
+}
+
+float FrameStats::getAchievedFps() const
+{
+  return averageRate(interval_.getSumMicros(), interval_.getCount(), 1000000.0f);
+}
+
+float FrameStats::getRequestedFps() const
+{
+  return averageRate(requestedDelaySumMs_, requestedDelayCount_, 1000.0f);
+}
+
+const FrameTimeHistogram &FrameStats::getDecodeHistogram() const
+{
+  return decode_;
+}
+
+const FrameTimeHistogram &FrameStats::getDrawHistogram() const
+{
+  return draw_;
+}
+
+const FrameTimeHistogram &FrameStats::getPresentHistogram() const
+{
+  return present_;
+}
+
+const FrameTimeHistogram &FrameStats::getIntervalHistogram() const
+{
+  return interval_;
+}
+
+void FrameStats::serialize(JsonVariant json) const
+{
+  if (json.isNull())
+  {
+    return;
+  }
+
+  json["frames"] = getFrameCount();
+  json["droppedFrames"] = getDroppedFrames();
+  json["achievedFps"] = getAchievedFps();
+  json["requestedFps"] = getRequestedFps();
+
+  JsonArray bounds = json["bucketUpperBoundsUs"].to<JsonArray>();
+  for (size_t index = 0; index < FrameTimeHistogram::kBucketCount - 1; ++index)
+  {
+    bounds.add(FrameTimeHistogram::getBucketUpperBoundMicros(index));
+  }
+
+  decode_.serialize(json["decode"].to<JsonObject>());
+  draw_.serialize(json["draw"].to<JsonObject>());
+  present_.serialize(json["present"].to<JsonObject>());
+  interval_.serialize(json["interval"].to<JsonObject>());
+}
+
+size_t FrameStats::formatSummary(char *buffer, size_t size) const
+{
+  const int written = snprintf(buffer, size, "FPS:%.1f/%.1f;DROP:%lu;DEC:%lu;DRW:%lu;PRS:%lu;",
+                               getAchievedFps(), getRequestedFps(),
+                               static_cast<unsigned long>(getDroppedFrames()),
+                               static_cast<unsigned long>(decode_.getAverageMicros()),
+                               static_cast<unsigned long>(draw_.getAverageMicros()),
+                               static_cast<unsigned long>(present_.getAverageMicros()));
+  if (written < 0)
+  {
+    return 0;
+  }
+  return static_cast<size_t>(written) < size ? static_cast<size_t>(written) : size - 1;
+}
+
+void FrameStats::reset()
+{
+  decode_.reset();
+  draw_.reset();
+  present_.reset();
+  interval_.reset();
+  frameCount_ = 0;
+  droppedFrames_ = 0;
+  requestedDelaySumMs_ = 0;
+  requestedDelayCount_ = 0;
+  hasLastFrame_ = false;
+}
@@ -0,0 +1,85 @@
+#ifndef FRAME_STATS_HPP
+#define FRAME_STATS_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <atomic>
+
+// Fixed-bucket histogram of durations in microseconds. Never allocates.
+// Written by the render loop only; the counters are atomics so the web and
+// BLE tasks can read them while frames are recorded.
+class FrameTimeHistogram
+{
+public:
+  static constexpr size_t kBucketCount = 12;
+
+  FrameTimeHistogram();
+
+  void record(uint32_t durationMicros);
+  void reset();
+
+  uint32_t getCount() const;
+  uint32_t getMinMicros() const;
+  uint32_t getMaxMicros() const;
+  uint32_t getAverageMicros() const;
+  uint32_t getBucket(size_t index) const;
+  uint64_t getSumMicros() const;
+
+  // Inclusive upper bound of a bucket, 0 for the overflow bucket.
+  static uint32_t getBucketUpperBoundMicros(size_t index);
+
+  void serialize(JsonVariant json) const;
+
+private:
+  std::atomic<uint32_t> buckets_[kBucketCount];
+  std::atomic<uint32_t> count_;
+  std::atomic<uint32_t> minMicros_;
+  std::atomic<uint32_t> maxMicros_;
+  std::atomic<uint64_t> sumMicros_;
+};
+
+class FrameStats
+{
+public:
+  FrameStats();
+
+  void recordFrame(uint32_t frameStartMicros, uint32_t decodeMicros, uint32_t drawMicros,
+                   uint32_t presentMicros, uint32_t requestedDelayMs);
+  // Forget the previous frame start so a GIF switch is not counted as a stall.
+  void restartTimeline();
+  // Safe to call from other tasks, the reset happens on the next recorded frame.
+  void requestReset();
+
+  uint32_t getFrameCount() const;
+  uint32_t getDroppedFrames() const;
+  float getAchievedFps() const;
+  float getRequestedFps() const;
+
+  const FrameTimeHistogram &getDecodeHistogram() const;
+  const FrameTimeHistogram &getDrawHistogram() const;
+  const FrameTimeHistogram &getPresentHistogram() const;
+  const FrameTimeHistogram &getIntervalHistogram() const;
+
+  void serialize(JsonVariant json) const;
+  size_t formatSummary(char *buffer, size_t size) const;
+
+private:
+  void reset();
+
+  FrameTimeHistogram decode_;
+  FrameTimeHistogram draw_;
+  FrameTimeHistogram present_;
+  FrameTimeHistogram interval_;
+  std::atomic<uint32_t> frameCount_;
+  std::atomic<uint32_t> droppedFrames_;
+  std::atomic<uint64_t> requestedDelaySumMs_;
+  std::atomic<uint32_t> requestedDelayCount_;
+  uint32_t lastFrameStartMicros_;
+  // Delay requested by the previous frame, which is what the interval to this one waited for.
+  uint32_t lastRequestedDelayMs_;
+  bool hasLastFrame_;
+  std::atomic<bool> resetRequested_;
+};
+
+#endif // FRAME_STATS_HPP
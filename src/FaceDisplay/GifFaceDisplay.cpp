@@ -1,11 +1,17 @@
 #include "GifFaceDisplay.hpp"
 
+#include "HeapMonitor.hpp"
+
 GifFaceDisplay *GifFaceDisplay::instance_ = nullptr;
 
 GifFaceDisplay::GifFaceDisplay()
     : gifFile_(),
       activeEmotionPath_(),
-      isEmotionPlaying_(false)
+      isEmotionPlaying_(false),
+      activeEmotionRevision_(0),
+      frameStats_(),
+      framePreview_(),
+      drawMicros_(0)
 {
   instance_ = this;
 }
@@ -27,26 +33,26 @@ bool GifFaceDisplay::initGif()
   return true;
 }
 
-void GifFaceDisplay::playEmotion(const String &emotionPath)
+void GifFaceDisplay::playEmotion(uint32_t emotionRevision, const char *emotionPath)
 {
+  HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Face);
+
   if (!displayReady())
   {
     return;
   }
 
-  if (!isEmotionPlaying_ || emotionPath != activeEmotionPath_)
+  if (!isEmotionPlaying_ || emotionRevision != activeEmotionRevision_)
   {
     if (!openEmotion(emotionPath))
     {
       return;
     }
+    activeEmotionRevision_ = emotionRevision;
   }
-  beforeFrameRendered();
 
-  const int result = gif_.playFrame(true, nullptr);
-  if (result >= 0)
+  if (renderFrame())
   {
-    afterFrameRendered();
     return;
   }
 
@@ -54,12 +60,67 @@ void GifFaceDisplay::playEmotion(const String &emotionPath)
   if (!restartEmotion())
   {
     closeEmotion();
-    Serial.printf("[E] Failed to continue GIF %s\n", emotionPath.c_str());
+    Serial.printf("[E] Failed to continue GIF %s\n", emotionPath);
     return;
   }
+  renderFrame();
+}
+
+FrameStats &GifFaceDisplay::getFrameStats()
+{
+  return frameStats_;
+}
+
+FramePreview &GifFaceDisplay::getFramePreview()
+{
+  return framePreview_;
+}
+
+void GifFaceDisplay::setPathResolver(std::function<String(const String &)> pathResolver)
+{
+  pathResolver_ = pathResolver;
+}
+
+bool GifFaceDisplay::renderFrame()
+{
+  const uint32_t frameStartMicros = micros();
   beforeFrameRendered();
-  gif_.playFrame(true, nullptr);
+
+  drawMicros_ = 0;
+  int frameDelayMs = 0;
+  // Frame pacing is done in waitForFrameDelay so decode time is not polluted by the sync delay.
+  if (gif_.playFrame(false, &frameDelayMs) < 0)
+  {
+    return false;
+  }
+  const uint32_t decodeEndMicros = micros();
+
   afterFrameRendered();
+  const uint32_t presentEndMicros = micros();
+
+  const uint32_t decodeAndDrawMicros = decodeEndMicros - frameStartMicros;
+  const uint32_t decodeMicros = decodeAndDrawMicros > drawMicros_ ? decodeAndDrawMicros - drawMicros_ : 0;
+  frameStats_.recordFrame(frameStartMicros, decodeMicros, drawMicros_,
+                          presentEndMicros - decodeEndMicros,
+                          frameDelayMs > 0 ? static_cast<uint32_t>(frameDelayMs) : 0);
+  framePreview_.frameCompleted();
+
+  waitForFrameDelay(frameStartMicros, frameDelayMs);
+  return true;
+}
+
+void GifFaceDisplay::waitForFrameDelay(uint32_t frameStartMicros, int frameDelayMs) const
+{
+  if (frameDelayMs <= 0)
+  {
+    return;
+  }
+
+  const uint32_t elapsedMs = (micros() - frameStartMicros) / 1000UL;
+  if (elapsedMs < static_cast<uint32_t>(frameDelayMs))
+  {
+    delay(static_cast<uint32_t>(frameDelayMs) - elapsedMs);
+  }
 }
 
 void GifFaceDisplay::afterFrameRendered()
@@ -74,7 +135,9 @@ void GifFaceDisplay::GIFDrawWrapper(GIFDRAW *pDraw)
 {
   if (instance_ != nullptr)
   {
+    const uint32_t drawStartMicros = micros();
     instance_->GIFDraw(pDraw);
+    instance_->drawMicros_ += micros() - drawStartMicros;
   }
 }
 
@@ -101,6 +164,12 @@ int32_t GifFaceDisplay::fileSeekWrapper(GIFFILE *pHandle, int32_t iPosition)
   return instance_ != nullptr ? instance_->fileSeek(pHandle, iPosition) : -1;
 }
 
+void GifFaceDisplay::plotPixel(int x, int y, uint16_t color565)
+{
+  drawPixel(x, y, color565);
+  framePreview_.setPixel(x, y, color565);
+}
+
 void GifFaceDisplay::GIFDraw(GIFDRAW *pDraw)
 {
   uint8_t *s;
@@ -150,7 +219,7 @@ void GifFaceDisplay::GIFDraw(GIFDRAW *pDraw)
       {
         for (int xOffset = 0; xOffset < iCount; xOffset++)
         {
-          drawPixel(x + xOffset + pDraw->iX, y, usTemp[xOffset]);
+          plotPixel(x + xOffset + pDraw->iX, y, usTemp[xOffset]);
         }
         x += iCount;
         iCount = 0;
@@ -180,7 +249,7 @@ void GifFaceDisplay::GIFDraw(GIFDRAW *pDraw)
     s = pDraw->pPixels;
     for (x = 0; x < pDraw->iWidth; x++)
     {
-      drawPixel(x + pDraw->iX, y, usPalette[*s++]);
+      plotPixel(x + pDraw->iX, y, usPalette[*s++]);
     }
   }
 }
@@ -282,7 +351,8 @@ bool GifFaceDisplay::openEmotion(const String &emotionPath, bool logTransition)
 
   closeEmotion();
 
-  if (!gif_.open(emotionPath.c_str(), fileOpenWrapper, fileCloseWrapper, fileReadWrapper,
+  const String filePath = pathResolver_ ? pathResolver_(emotionPath) : emotionPath;
+  if (!gif_.open(filePath.c_str(), fileOpenWrapper, fileCloseWrapper, fileReadWrapper,
                  fileSeekWrapper, GIFDrawWrapper))
   {
     Serial.printf("[E] Failed to open GIF %s\n", emotionPath.c_str());
@@ -291,6 +361,9 @@ bool GifFaceDisplay::openEmotion(const String &emotionPath, bool logTransition)
 
   activeEmotionPath_ = emotionPath;
   isEmotionPlaying_ = true;
+  framePreview_.setCanvasSize(static_cast<uint16_t>(gif_.getCanvasWidth()),
+                              static_cast<uint16_t>(gif_.getCanvasHeight()));
+  frameStats_.restartTimeline();
 
   if (logTransition)
   {
@@ -6,8 +6,12 @@
 #include <LittleFS.h>
 
 #include <Arduino.h>
+#include <functional>
 #include <Graphics/Color.hpp>
 
+#include "FramePreview.hpp"
+#include "FrameStats.hpp"
+
 class GifFaceDisplay {
 public:
   virtual ~GifFaceDisplay();
@@ -15,7 +19,13 @@ public:
   virtual bool displayReady() const = 0;
 
 
-  void playEmotion(const String &emotionPath);
+  // Opens `emotionPath` only when `emotionRevision` differs from the playing
+  // one (see StateStore::Snapshot), so the per-frame check is an integer compare.
+  void playEmotion(uint32_t emotionRevision, const char *emotionPath);
+  FrameStats &getFrameStats();
+  FramePreview &getFramePreview();
+  // Maps an emotion path to the file to open, e.g. a stored asset's content path.
+  void setPathResolver(std::function<String(const String &)> pathResolver);
 
   protected:
   GifFaceDisplay();
@@ -25,8 +35,11 @@ public:
   virtual void beforeFrameRendered();
 
   bool initGif();
+  bool renderFrame();
+  void waitForFrameDelay(uint32_t frameStartMicros, int frameDelayMs) const;
 
   void GIFDraw(GIFDRAW *pDraw);
+  void plotPixel(int x, int y, uint16_t color565);
   void *fileOpen(const char *filename, int32_t *pFileSize);
   void fileClose(void *pHandle);
   int32_t fileRead(GIFFILE *pHandle, uint8_t *pBuf, int32_t iLen);
@@ -48,6 +61,11 @@ public:
   File gifFile_;
   String activeEmotionPath_;
   bool isEmotionPlaying_;
+  uint32_t activeEmotionRevision_;
+  FrameStats frameStats_;
+  FramePreview framePreview_;
+  uint32_t drawMicros_;
+  std::function<String(const String &)> pathResolver_;
 };
 
 #endif // FACE_DISPLAY_HPP
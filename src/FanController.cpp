@@ -1,12 +1,15 @@
 #include "FanController.hpp"
 
-FanController::FanController(uint8_t pwmPin, uint8_t channel, uint32_t frequency,
-                             uint8_t resolution)
-    : pwmPin_(pwmPin),
+FanController::FanController(StateStore &stateStore, uint8_t pwmPin, uint8_t channel,
+                             uint32_t frequency, uint8_t resolution)
+    : stateStore_(stateStore),
+      pwmPin_(pwmPin),
       channel_(channel),
       frequency_(frequency),
       resolution_(resolution),
-      dutyCycle_(100) {}
+      dutyCycle_(100) {
+  stateStore_.publishFanDutyCycle(dutyCycle_);
+}
 
 void FanController::begin() {
   pinMode(pwmPin_, OUTPUT);
@@ -21,6 +24,7 @@ bool FanController::setDutyCycle(int dutyCycle) {
   }
   dutyCycle_ = dutyCycle;
   ledcWrite(channel_, dutyCycle_);
+  stateStore_.publishFanDutyCycle(dutyCycle_);
   return true;
 }
 
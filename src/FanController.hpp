@@ -3,9 +3,11 @@
 
 #include <Arduino.h>
 
+#include "StateStore.hpp"
+
 class FanController {
 public:
-  FanController(uint8_t pwmPin, uint8_t channel, uint32_t frequency, uint8_t resolution);
+  FanController(StateStore &stateStore, uint8_t pwmPin, uint8_t channel, uint32_t frequency, uint8_t resolution);
 
   void begin();
   bool setDutyCycle(int dutyCycle);
@@ -15,6 +17,7 @@ public:
   float getDutyCyclePercent() const;
 
 private:
+  StateStore &stateStore_;
   uint8_t pwmPin_;
   uint8_t channel_;
   uint32_t frequency_;
@@ -0,0 +1,241 @@
+#include "FileIndex.hpp"
+
+#include <strings.h>
+
+FileQuery FileQuery::fromFilter(const String &filter)
+{
+  FileQuery query;
+  if (filter.isEmpty())
+  {
+    return query;
+  }
+
+  if (filter.startsWith("*."))
+  {
+    query.extension = filter.substring(2);
+  }
+  else if (filter.endsWith("/"))
+  {
+    query.prefix = filter;
+  }
+  else
+  {
+    query.contains = filter;
+  }
+  query.normalize();
+  return query;
+}
+
+void FileQuery::normalize()
+{
+  if (!prefix.isEmpty() && !prefix.startsWith("/"))
+  {
+    prefix = "/" + prefix;
+  }
+
+  if (extension.startsWith("."))
+  {
+    extension = extension.substring(1);
+  }
+}
+
+const char *FileIndex::Entry::name() const
+{
+  return path.c_str() + nameOffset;
+}
+
+const char *FileIndex::Entry::extension() const
+{
+  return path.c_str() + extensionOffset;
+}
+
+void FileIndex::rebuild(fs::FS &fs)
+{
+  clear();
+
+  File rootDir = fs.open("/");
+  if (!rootDir || !rootDir.isDirectory())
+  {
+    Serial.println(F("[E] Failed to open LittleFS root directory"));
+    return;
+  }
+
+  collect(rootDir);
+  rootDir.close();
+}
+
+void FileIndex::clear()
+{
+  entries_.clear();
+}
+
+void FileIndex::upsert(const String &path, size_t size, time_t modified)
+{
+  const size_t position = lowerBound(path.c_str());
+  if (position < entries_.size() && entries_[position].path == path)
+  {
+    entries_[position].size = size;
+    entries_[position].modified = modified;
+    return;
+  }
+
+  Entry entry;
+  entry.path = path;
+  entry.size = size;
+  entry.modified = modified;
+
+  const int lastSlash = path.lastIndexOf('/');
+  entry.nameOffset = static_cast<uint16_t>(lastSlash + 1);
+  const int lastDot = path.lastIndexOf('.');
+  entry.extensionOffset = static_cast<uint16_t>(lastDot > lastSlash ? lastDot + 1 : path.length());
+
+  entries_.insert(entries_.begin() + position, std::move(entry));
+}
+
+bool FileIndex::remove(const String &path)
+{
+  const size_t position = lowerBound(path.c_str());
+  if (position >= entries_.size() || entries_[position].path != path)
+  {
+    return false;
+  }
+
+  entries_.erase(entries_.begin() + position);
+  return true;
+}
+
+bool FileIndex::rename(const String &from, const String &to)
+{
+  const Entry *entry = find(from);
+  if (entry == nullptr)
+  {
+    return false;
+  }
+
+  const size_t size = entry->size;
+  const time_t modified = entry->modified;
+  remove(from);
+  upsert(to, size, modified);
+  return true;
+}
+
+size_t FileIndex::size() const
+{
+  return entries_.size();
+}
+
+const FileIndex::Entry *FileIndex::at(size_t position) const
+{
+  return position < entries_.size() ? &entries_[position] : nullptr;
+}
+
+const FileIndex::Entry *FileIndex::find(const String &path) const
+{
+  const size_t position = lowerBound(path.c_str());
+  if (position < entries_.size() && entries_[position].path == path)
+  {
+    return &entries_[position];
+  }
+  return nullptr;
+}
+
+size_t FileIndex::firstCandidate(const FileQuery &query) const
+{
+  if (query.prefix.isEmpty())
+  {
+    return 0;
+  }
+  return lowerBound(query.prefix.c_str());
+}
+
+bool FileIndex::canMatchFrom(const FileQuery &query, size_t position) const
+{
+  if (position >= entries_.size())
+  {
+    return false;
+  }
+
+  if (query.prefix.isEmpty())
+  {
+    return true;
+  }
+
+  // Entries are sorted, so the prefix range ends at the first path without it.
+  return strncmp(entries_[position].path.c_str(), query.prefix.c_str(), query.prefix.length()) == 0;
+}
+
+bool FileIndex::matches(const FileQuery &query, const Entry &entry) const
+{
+  if (!query.prefix.isEmpty() &&
+      strncmp(entry.path.c_str(), query.prefix.c_str(), query.prefix.length()) != 0)
+  {
+    return false;
+  }
+
+  if (!query.extension.isEmpty() && strcasecmp(entry.extension(), query.extension.c_str()) != 0)
+  {
+    return false;
+  }
+
+  if (!query.contains.isEmpty() && strstr(entry.path.c_str(), query.contains.c_str()) == nullptr)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+size_t FileIndex::count(const FileQuery &query) const
+{
+  size_t matchCount = 0;
+  for (size_t position = firstCandidate(query); canMatchFrom(query, position); ++position)
+  {
+    if (matches(query, entries_[position]))
+    {
+      ++matchCount;
+    }
+  }
+  return matchCount;
+}
+
+void FileIndex::collect(File directory)
+{
+  File entry = directory.openNextFile();
+  while (entry)
+  {
+    if (entry.isDirectory())
+    {
+      // Hidden directories (the asset store) are not listed as files.
+      if (entry.name()[0] != '.')
+      {
+        collect(entry);
+      }
+    }
+    else
+    {
+      upsert(entry.path(), entry.size(), entry.getLastWrite());
+    }
+
+    entry.close();
+    entry = directory.openNextFile();
+  }
+}
+
+size_t FileIndex::lowerBound(const char *path) const
+{
+  size_t low = 0;
+  size_t high = entries_.size();
+  while (low < high)
+  {
+    const size_t middle = low + (high - low) / 2;
+    if (strcmp(entries_[middle].path.c_str(), path) < 0)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  return low;
+}
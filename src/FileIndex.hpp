@@ -0,0 +1,64 @@
+#ifndef FILE_INDEX_HPP
+#define FILE_INDEX_HPP
+
+#include <FS.h>
+
+#include <Arduino.h>
+#include <time.h>
+#include <vector>
+
+// Selects files from the index. Empty fields match everything, limit 0 means no limit.
+struct FileQuery {
+  String prefix;
+  String extension;
+  String contains;
+  size_t offset = 0;
+  size_t limit = 0;
+
+  // Legacy `filter` syntax: "anims/" is a directory prefix, "*.gif" an extension, anything else a substring.
+  static FileQuery fromFilter(const String &filter);
+  // Adds the leading '/' to the prefix and strips the '.' from the extension; index lookups expect this form.
+  void normalize();
+};
+
+// In-memory list of the files on flash, sorted by path. Built once at mount and
+// kept up to date by FileManager so listings never touch the filesystem.
+class FileIndex {
+public:
+  struct Entry {
+    String path;
+    size_t size = 0;
+    time_t modified = 0;
+    uint16_t nameOffset = 0;
+    uint16_t extensionOffset = 0;
+
+    const char *name() const;
+    const char *extension() const;
+  };
+
+  void rebuild(fs::FS &fs);
+  void clear();
+
+  void upsert(const String &path, size_t size, time_t modified);
+  bool remove(const String &path);
+  bool rename(const String &from, const String &to);
+
+  size_t size() const;
+  const Entry *at(size_t position) const;
+  const Entry *find(const String &path) const;
+
+  // Position of the first entry that can match, a binary search when the query has a prefix.
+  size_t firstCandidate(const FileQuery &query) const;
+  // False once no entry at or after `position` can match.
+  bool canMatchFrom(const FileQuery &query, size_t position) const;
+  bool matches(const FileQuery &query, const Entry &entry) const;
+  size_t count(const FileQuery &query) const;
+
+private:
+  void collect(File directory);
+  size_t lowerBound(const char *path) const;
+
+  std::vector<Entry> entries_;
+};
+
+#endif // FILE_INDEX_HPP
@@ -1,73 +1,103 @@
 #include "FileManager.hpp"
 
+#include "HeapMonitor.hpp"
 #include "float_helper.hpp"
 
-namespace {
+FileCursor::FileCursor(const FileIndex &index, std::recursive_mutex &mutex, const FileQuery &query)
+    : index_(index),
+      mutex_(&mutex),
+      query_(query),
+      position_(0),
+      skipped_(0),
+      returned_(0)
+{
+  std::lock_guard<std::recursive_mutex> lock(*mutex_);
+  position_ = index_.firstCandidate(query_);
+}
 
-void collectFilesRecursive(File directory, const String &normalizedFilter,
-                           std::vector<Model::File> &files)
+bool FileCursor::next(Model::File &file)
 {
-  if (!directory || !directory.isDirectory())
+  std::lock_guard<std::recursive_mutex> lock(*mutex_);
+  if (query_.limit > 0 && returned_ >= query_.limit)
   {
-    return;
+    return false;
   }
 
-  File entry = directory.openNextFile();
-  while (entry)
+  while (index_.canMatchFrom(query_, position_))
   {
-    if (entry.isDirectory())
+    const FileIndex::Entry *entry = index_.at(position_++);
+    if (!index_.matches(query_, *entry))
     {
-      collectFilesRecursive(entry, normalizedFilter, files);
-      entry.close();
-      entry = directory.openNextFile();
       continue;
     }
 
-    Model::File info;
-    info.path = entry.path();
-    info.name = FileHelper::GetNameOnly(info.path);
-
-    if (normalizedFilter.isEmpty() || info.name.indexOf(normalizedFilter) >= 0 ||
-        info.path.indexOf(normalizedFilter) >= 0)
+    if (skipped_ < query_.offset)
     {
-      files.push_back(std::move(info));
+      ++skipped_;
+      continue;
     }
 
-    entry.close();
-    entry = directory.openNextFile();
+    file.path = entry->path;
+    file.name = FileHelper::GetNameOnly(file.path);
+    file.size = entry->size;
+    file.modified = entry->modified;
+    ++returned_;
+    return true;
   }
-}
 
-} // namespace
+  return false;
+}
 
 bool FileManager::begin(bool formatOnFail)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   if (!LittleFS.begin(formatOnFail))
   {
     Serial.println(F("LittleFS mount failed!"));
     return false;
   }
 
+  if (!assets_.begin(LittleFS))
+  {
+    Serial.println(F("[E] Asset store unavailable, stored files will be missing or read only."));
+  }
+
+  index_.rebuild(LittleFS);
+  for (const auto &reference : assets_.getReferences())
+  {
+    index_.upsert(reference.path, reference.size, reference.modified);
+  }
   return true;
 }
 
 std::vector<Model::File> FileManager::getFiles(const String &filter) const
 {
-  std::vector<Model::File> files;
+  HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Files);
 
-  File rootDir = LittleFS.open("/");
-  if (!rootDir || !rootDir.isDirectory())
+  std::vector<Model::File> files;
+  FileCursor cursor = openCursor(filter);
+  Model::File file;
+  while (cursor.next(file))
   {
-    Serial.println(F("[E] Failed to open LittleFS root directory"));
-    return files;
+    files.push_back(file);
   }
+  return files;
+}
 
-  const String normalizedFilter = String(filter);
+FileCursor FileManager::openCursor(const String &filter) const
+{
+  return FileCursor(index_, mutex_, FileQuery::fromFilter(filter));
+}
 
-  collectFilesRecursive(rootDir, normalizedFilter, files);
+FileCursor FileManager::openCursor(const FileQuery &query) const
+{
+  return FileCursor(index_, mutex_, query);
+}
 
-  rootDir.close();
-  return files;
+size_t FileManager::countFiles(const FileQuery &query) const
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return index_.count(query);
 }
 
 void FileManager::printEmotions() const
@@ -81,7 +111,8 @@ void FileManager::printEmotions() const
 
 bool FileManager::exists(const String &path) const
 {
-  return LittleFS.exists(path);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return assets_.find(path) != nullptr || LittleFS.exists(path);
 }
 
 size_t FileManager::totalBytes() const
@@ -96,7 +127,7 @@ size_t FileManager::usedBytes() const
 
 bool FileManager::readFile(const String &path, String &content) const
 {
-  File file = LittleFS.open(path, FILE_READ);
+  File file = LittleFS.open(resolvePath(path), FILE_READ);
   if (!file)
   {
     return false;
@@ -108,8 +139,9 @@ bool FileManager::readFile(const String &path, String &content) const
 }
 
 bool FileManager::writeFile(const String &path, const uint8_t *data, size_t len,
-                            bool append) const
+                            bool append)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   const char *mode = append ? FILE_APPEND : FILE_WRITE;
   File file = LittleFS.open(path, mode);
   if (!file)
@@ -118,16 +150,161 @@ bool FileManager::writeFile(const String &path, const uint8_t *data, size_t len,
   }
 
   const size_t written = file.write(data, len);
+  index_.upsert(path, file.size(), time(nullptr));
   file.close();
   return written == len;
 }
 
-bool FileManager::removeFile(const String &path) const
+bool FileManager::removeFile(const String &path)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (assets_.find(path) != nullptr)
+  {
+    if (!assets_.unlink(path))
+    {
+      return false;
+    }
+    index_.remove(path);
+    return true;
+  }
+
+  if (!LittleFS.remove(path))
+  {
+    return false;
+  }
+
+  index_.remove(path);
+  return true;
+}
+
+bool FileManager::renameFile(const String &from, const String &to)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (assets_.find(from) != nullptr)
+  {
+    if (!assets_.rename(from, to))
+    {
+      return false;
+    }
+    removeShadowedFile(to);
+    index_.rename(from, to);
+    return true;
+  }
+
+  if (!LittleFS.exists(from))
+  {
+    return false;
+  }
+  // The file replaces whatever is at the target, including a stored asset that
+  // would otherwise keep shadowing it.
+  if (assets_.find(to) != nullptr && !assets_.unlink(to))
+  {
+    return false;
+  }
+
+  if (!LittleFS.rename(from, to))
+  {
+    index_.remove(to);
+    return false;
+  }
+
+  index_.remove(from);
+  refreshIndexEntry(to);
+  return true;
+}
+
+void FileManager::refreshIndexEntry(const String &path)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  File file = LittleFS.open(path, FILE_READ);
+  if (!file)
+  {
+    index_.remove(path);
+    return;
+  }
+
+  index_.upsert(path, file.size(), file.getLastWrite());
+  file.close();
+}
+
+void FileManager::removeShadowedFile(const String &path)
+{
+  // Only after the reference is saved, so a failed store keeps the old file.
+  if (LittleFS.exists(path) && !LittleFS.remove(path))
+  {
+    Serial.printf("[W] Could not remove %s replaced by a stored asset\n", path.c_str());
+  }
+}
+
+void FileManager::indexAsset(const String &path)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  const AssetStore::Reference *reference = assets_.find(path);
+  if (reference != nullptr)
+  {
+    index_.upsert(path, reference->size, reference->modified);
+  }
+}
+
+String FileManager::resolvePath(const String &path) const
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  const AssetStore::Reference *reference = assets_.find(path);
+  return reference != nullptr ? assets_.getBlobPath(reference->hash) : path;
+}
+
+bool FileManager::storeAsset(const String &tempPath, const String &path, bool &deduplicated)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (!assets_.store(tempPath, path, deduplicated))
+  {
+    return false;
+  }
+
+  removeShadowedFile(path);
+  index_.remove(tempPath);
+  indexAsset(path);
+  return true;
+}
+
+bool FileManager::linkAsset(const String &hash, const String &path)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (!hasAsset(hash))
+  {
+    return false;
+  }
+
+  if (!assets_.link(hash, path))
+  {
+    return false;
+  }
+
+  removeShadowedFile(path);
+  indexAsset(path);
+  return true;
+}
+
+bool FileManager::findAsset(const String &path, AssetStore::Reference &reference) const
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  const AssetStore::Reference *stored = assets_.find(path);
+  if (stored == nullptr)
+  {
+    return false;
+  }
+  reference = *stored;
+  return true;
+}
+
+bool FileManager::hasAsset(const String &hash) const
 {
-  return LittleFS.remove(path);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return assets_.findByHash(hash) != nullptr;
 }
 
-bool FileManager::renameFile(const String &from, const String &to) const
+AssetStore::Stats FileManager::getAssetStats() const
 {
-  return LittleFS.rename(from, to);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return assets_.getStats();
 }
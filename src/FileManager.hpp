@@ -4,14 +4,40 @@
 #include <LittleFS.h>
 
 #include <Arduino.h>
+#include <mutex>
 #include <vector>
 
+#include "AssetStore.hpp"
+#include "FileIndex.hpp"
 #include "Model/AnimationFile.hpp"
 
+// Iterates the file index, one matching file per next() call. Each call
+// holds the FileManager lock; entries changed between calls may be skipped.
+class FileCursor {
+public:
+  FileCursor(const FileIndex &index, std::recursive_mutex &mutex, const FileQuery &query);
+
+  bool next(Model::File &file);
+
+private:
+  const FileIndex &index_;
+  std::recursive_mutex *mutex_;
+  FileQuery query_;
+  size_t position_;
+  size_t skipped_;
+  size_t returned_;
+};
+
+// The index and asset references are shared by the web handlers (AsyncTCP
+// task), the boot background task and the render loop, so every access goes
+// through a lock. Nothing hands out pointers into them.
 class FileManager {
 public:
   bool begin(bool formatOnFail = true);
   std::vector<Model::File> getFiles(const String &filter = "") const;
+  FileCursor openCursor(const String &filter = "") const;
+  FileCursor openCursor(const FileQuery &query) const;
+  size_t countFiles(const FileQuery &query) const;
   void printEmotions() const;
 
   bool exists(const String &path) const;
@@ -19,9 +45,30 @@ public:
   size_t usedBytes() const;
   bool readFile(const String &path, String &content) const;
   bool writeFile(const String &path, const uint8_t *data, size_t len,
-                 bool append = false) const;
-  bool removeFile(const String &path) const;
-  bool renameFile(const String &from, const String &to) const;
+                 bool append = false);
+  bool removeFile(const String &path);
+  bool renameFile(const String &from, const String &to);
+
+  // Path to open for reading; stored assets live under their content hash.
+  String resolvePath(const String &path) const;
+  // Moves an uploaded temp file into the asset store under `path`.
+  bool storeAsset(const String &tempPath, const String &path, bool &deduplicated);
+  bool linkAsset(const String &hash, const String &path);
+  // Copies the reference stored for `path`, false if it is a plain file.
+  bool findAsset(const String &path, AssetStore::Reference &reference) const;
+  bool hasAsset(const String &hash) const;
+  AssetStore::Stats getAssetStats() const;
+
+private:
+  void refreshIndexEntry(const String &path);
+  void indexAsset(const String &path);
+  // Removes the plain file a stored asset reference now stands for.
+  void removeShadowedFile(const String &path);
+
+  // Recursive because public calls nest (e.g. linkAsset -> hasAsset).
+  mutable std::recursive_mutex mutex_;
+  FileIndex index_;
+  AssetStore assets_;
 };
 
 #endif // FILE_MANAGER_HPP
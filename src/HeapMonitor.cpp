@@ -0,0 +1,290 @@
+#include "HeapMonitor.hpp"
+
+#include <atomic>
+#include <new>
+
+#ifdef PROTOGEN_TRACE_ALLOCATIONS
+#include <esp_heap_caps.h>
+#endif
+
+namespace
+{
+struct HotSpot
+{
+  std::atomic<uintptr_t> caller;
+  std::atomic<uint32_t> allocations;
+  std::atomic<uint32_t> bytes;
+};
+
+std::atomic<uint32_t> subsystemAllocations[static_cast<size_t>(HeapMonitor::Subsystem::Count)];
+std::atomic<uint32_t> subsystemBytes[static_cast<size_t>(HeapMonitor::Subsystem::Count)];
+HotSpot hotSpots[HeapMonitor::kHotSpotCount];
+std::atomic<uint32_t> untrackedHotSpotAllocations(0);
+
+thread_local HeapMonitor::Subsystem currentSubsystem = HeapMonitor::Subsystem::Other;
+HeapMonitor::Subsystem fallbackSubsystem = HeapMonitor::Subsystem::Other;
+// Set while operator new runs, so the malloc it makes is not counted twice.
+thread_local bool insideOperatorNew = false;
+bool fallbackInsideOperatorNew = false;
+
+const char *const kSubsystemNames[] = {
+    "other", "web", "ble", "face", "ears", "tilt", "display", "files", "settings"};
+
+// Task-local storage is only valid once the scheduler runs; global constructors allocate before that.
+HeapMonitor::Subsystem &currentSubsystemSlot()
+{
+#if defined(ESP_PLATFORM)
+  if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+  {
+    return fallbackSubsystem;
+  }
+#endif
+  return currentSubsystem;
+}
+
+bool &insideOperatorNewSlot()
+{
+#if defined(ESP_PLATFORM)
+  if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+  {
+    return fallbackInsideOperatorNew;
+  }
+#endif
+  return insideOperatorNew;
+}
+
+uintptr_t normalizeCaller(uintptr_t caller)
+{
+#if defined(__XTENSA__)
+  // Windowed ABI keeps the call increment in the top two bits of the return address.
+  return (caller & 0x3FFFFFFFU) | 0x40000000U;
+#else
+  return caller;
+#endif
+}
+
+void recordHotSpot(uintptr_t caller, size_t size)
+{
+  size_t slot = (caller >> 2) % HeapMonitor::kHotSpotCount;
+  for (size_t probe = 0; probe < HeapMonitor::kHotSpotCount; ++probe)
+  {
+    HotSpot &hotSpot = hotSpots[slot];
+    uintptr_t expected = hotSpot.caller.load(std::memory_order_relaxed);
+    if (expected == 0 &&
+        hotSpot.caller.compare_exchange_strong(expected, caller, std::memory_order_relaxed))
+    {
+      expected = caller;
+    }
+
+    if (expected == caller)
+    {
+      hotSpot.allocations.fetch_add(1, std::memory_order_relaxed);
+      hotSpot.bytes.fetch_add(static_cast<uint32_t>(size), std::memory_order_relaxed);
+      return;
+    }
+
+    slot = (slot + 1) % HeapMonitor::kHotSpotCount;
+  }
+
+  untrackedHotSpotAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+} // namespace
+
+#ifdef PROTOGEN_TRACE_ALLOCATIONS
+extern "C"
+{
+  void *__real_malloc(size_t size);
+  void *__real_calloc(size_t count, size_t size);
+  void *__real_realloc(void *pointer, size_t size);
+
+  void *__real__Znwj(size_t size);
+  void *__real__Znaj(size_t size);
+  void *__real__ZnwjRKSt9nothrow_t(size_t size, const std::nothrow_t &tag);
+  void *__real__ZnajRKSt9nothrow_t(size_t size, const std::nothrow_t &tag);
+
+  // C allocations are mostly made by library helpers (String::changeBuffer,
+  // strdup, JSON pools), so the site reported is the caller of that helper.
+  void *__wrap_malloc(size_t size)
+  {
+    if (!insideOperatorNewSlot())
+    {
+      HeapMonitor::recordAllocation(size, reinterpret_cast<uintptr_t>(__builtin_return_address(1)));
+    }
+    return __real_malloc(size);
+  }
+
+  void *__wrap_calloc(size_t count, size_t size)
+  {
+    HeapMonitor::recordAllocation(count * size, reinterpret_cast<uintptr_t>(__builtin_return_address(1)));
+    return __real_calloc(count, size);
+  }
+
+  // Only reallocs that may need a new block count; shrinking and freeing do not.
+  void *__wrap_realloc(void *pointer, size_t size)
+  {
+    if (size > 0 && (pointer == nullptr || size > heap_caps_get_allocated_size(pointer)))
+    {
+      HeapMonitor::recordAllocation(size, reinterpret_cast<uintptr_t>(__builtin_return_address(1)));
+    }
+    return __real_realloc(pointer, size);
+  }
+
+  // operator new is called directly from the code that owns the object.
+  void *__wrap__Znwj(size_t size)
+  {
+    HeapMonitor::recordAllocation(size, reinterpret_cast<uintptr_t>(__builtin_return_address(0)));
+    insideOperatorNewSlot() = true;
+    void *pointer = __real__Znwj(size);
+    insideOperatorNewSlot() = false;
+    return pointer;
+  }
+
+  void *__wrap__Znaj(size_t size)
+  {
+    HeapMonitor::recordAllocation(size, reinterpret_cast<uintptr_t>(__builtin_return_address(0)));
+    insideOperatorNewSlot() = true;
+    void *pointer = __real__Znaj(size);
+    insideOperatorNewSlot() = false;
+    return pointer;
+  }
+
+  void *__wrap__ZnwjRKSt9nothrow_t(size_t size, const std::nothrow_t &tag)
+  {
+    HeapMonitor::recordAllocation(size, reinterpret_cast<uintptr_t>(__builtin_return_address(0)));
+    insideOperatorNewSlot() = true;
+    void *pointer = __real__ZnwjRKSt9nothrow_t(size, tag);
+    insideOperatorNewSlot() = false;
+    return pointer;
+  }
+
+  void *__wrap__ZnajRKSt9nothrow_t(size_t size, const std::nothrow_t &tag)
+  {
+    HeapMonitor::recordAllocation(size, reinterpret_cast<uintptr_t>(__builtin_return_address(0)));
+    insideOperatorNewSlot() = true;
+    void *pointer = __real__ZnajRKSt9nothrow_t(size, tag);
+    insideOperatorNewSlot() = false;
+    return pointer;
+  }
+}
+#endif
+
+HeapMonitor::Scope::Scope(Subsystem subsystem)
+    : previous_(currentSubsystemSlot())
+{
+  currentSubsystemSlot() = subsystem;
+}
+
+HeapMonitor::Scope::~Scope()
+{
+  currentSubsystemSlot() = previous_;
+}
+
+bool HeapMonitor::isTracingEnabled()
+{
+#ifdef PROTOGEN_TRACE_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+const char *HeapMonitor::getSubsystemName(Subsystem subsystem)
+{
+  const size_t index = static_cast<size_t>(subsystem);
+  return index < static_cast<size_t>(Subsystem::Count) ? kSubsystemNames[index] : "unknown";
+}
+
+uint32_t HeapMonitor::getAllocationCount(Subsystem subsystem)
+{
+  const size_t index = static_cast<size_t>(subsystem);
+  return index < static_cast<size_t>(Subsystem::Count) ? subsystemAllocations[index].load() : 0;
+}
+
+uint32_t HeapMonitor::getAllocatedBytes(Subsystem subsystem)
+{
+  const size_t index = static_cast<size_t>(subsystem);
+  return index < static_cast<size_t>(Subsystem::Count) ? subsystemBytes[index].load() : 0;
+}
+
+void HeapMonitor::recordAllocation(size_t size, uintptr_t caller)
+{
+  const size_t index = static_cast<size_t>(currentSubsystemSlot());
+  subsystemAllocations[index].fetch_add(1, std::memory_order_relaxed);
+  subsystemBytes[index].fetch_add(static_cast<uint32_t>(size), std::memory_order_relaxed);
+  recordHotSpot(normalizeCaller(caller), size);
+}
+
+void HeapMonitor::resetCounters()
+{
+  for (size_t index = 0; index < static_cast<size_t>(Subsystem::Count); ++index)
+  {
+    subsystemAllocations[index] = 0;
+    subsystemBytes[index] = 0;
+  }
+
+  for (auto &hotSpot : hotSpots)
+  {
+    hotSpot.allocations = 0;
+    hotSpot.bytes = 0;
+    hotSpot.caller = 0;
+  }
+  untrackedHotSpotAllocations = 0;
+}
+
+void HeapMonitor::serialize(JsonVariant json)
+{
+  if (json.isNull())
+  {
+    return;
+  }
+
+  const uint32_t freeBytes = ESP.getFreeHeap();
+  const uint32_t largestFreeBlockBytes = ESP.getMaxAllocHeap();
+
+  float fragmentationPercent = 0.0f;
+  if (freeBytes > 0U)
+  {
+    fragmentationPercent = 100.0f - (static_cast<float>(largestFreeBlockBytes) * 100.0f) /
+                                        static_cast<float>(freeBytes);
+  }
+
+  json["totalBytes"] = ESP.getHeapSize();
+  json["freeBytes"] = freeBytes;
+  json["minFreeBytes"] = ESP.getMinFreeHeap();
+  json["largestFreeBlockBytes"] = largestFreeBlockBytes;
+  json["fragmentationPercent"] = fragmentationPercent;
+  json["tracing"] = isTracingEnabled();
+
+  if (!isTracingEnabled())
+  {
+    return;
+  }
+
+  JsonArray subsystems = json["subsystems"].to<JsonArray>();
+  for (size_t index = 0; index < static_cast<size_t>(Subsystem::Count); ++index)
+  {
+    JsonObject subsystem = subsystems.add<JsonObject>();
+    subsystem["name"] = kSubsystemNames[index];
+    subsystem["allocations"] = subsystemAllocations[index].load();
+    subsystem["bytes"] = subsystemBytes[index].load();
+  }
+
+  JsonArray hotSpotsArray = json["hotSpots"].to<JsonArray>();
+  for (const auto &hotSpot : hotSpots)
+  {
+    const uintptr_t caller = hotSpot.caller.load();
+    if (caller == 0)
+    {
+      continue;
+    }
+
+    char callerHex[12];
+    snprintf(callerHex, sizeof(callerHex), "0x%08lx", static_cast<unsigned long>(caller));
+
+    JsonObject hotSpotObject = hotSpotsArray.add<JsonObject>();
+    hotSpotObject["caller"] = callerHex;
+    hotSpotObject["allocations"] = hotSpot.allocations.load();
+    hotSpotObject["bytes"] = hotSpot.bytes.load();
+  }
+  json["untrackedHotSpotAllocations"] = untrackedHotSpotAllocations.load();
+}
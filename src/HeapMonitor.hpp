@@ -0,0 +1,55 @@
+#ifndef HEAP_MONITOR_HPP
+#define HEAP_MONITOR_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Heap usage/fragmentation report plus an optional allocation tracer.
+// The tracer is compiled in with PROTOGEN_TRACE_ALLOCATIONS and needs the
+// malloc/calloc/realloc and operator new linker wraps from the
+// esp32-trinity-alloc-trace env.
+class HeapMonitor
+{
+public:
+  enum class Subsystem : uint8_t
+  {
+    Other,
+    Web,
+    Ble,
+    Face,
+    Ears,
+    Tilt,
+    Display,
+    Files,
+    Settings,
+    Count,
+  };
+
+  // Attributes allocations made on the current task to a subsystem until destroyed.
+  class Scope
+  {
+  public:
+    explicit Scope(Subsystem subsystem);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    Subsystem previous_;
+  };
+
+  static constexpr size_t kHotSpotCount = 32;
+
+  static bool isTracingEnabled();
+  static const char *getSubsystemName(Subsystem subsystem);
+  static uint32_t getAllocationCount(Subsystem subsystem);
+  static uint32_t getAllocatedBytes(Subsystem subsystem);
+
+  static void recordAllocation(size_t size, uintptr_t caller);
+  static void resetCounters();
+
+  static void serialize(JsonVariant json);
+};
+
+#endif // HEAP_MONITOR_HPP
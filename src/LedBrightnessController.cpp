@@ -1,9 +1,8 @@
 #include "LedBrightnessController.hpp"
 
-LedBrightnessController::LedBrightnessController() : ledBrightness_() {}
-void LedBrightnessController::setBrightness(uint8_t brightness) { ledBrightness_.setBrightness(brightness); }
-void LedBrightnessController::setBrightnessPercent(float percent) { ledBrightness_.setBrightnessPercent(percent); }
+LedBrightnessController::LedBrightnessController(StateStore &stateStore) : stateStore_(stateStore), ledBrightness_() { stateStore_.publishBrightness(ledBrightness_.getBrightness()); }
+void LedBrightnessController::setBrightness(uint8_t brightness) { ledBrightness_.setBrightness(brightness); stateStore_.publishBrightness(ledBrightness_.getBrightness()); }
+void LedBrightnessController::setBrightnessPercent(float percent) { ledBrightness_.setBrightnessPercent(percent); stateStore_.publishBrightness(ledBrightness_.getBrightness()); }
 uint8_t LedBrightnessController::getBrightness() const { return ledBrightness_.getBrightness(); }
 float LedBrightnessController::getBrightnessPercent() const { return ledBrightness_.getBrightnessPercent(); }
-LedBrightness &LedBrightnessController::getLedBrightness() { return ledBrightness_; }
 const LedBrightness &LedBrightnessController::getLedBrightness() const { return ledBrightness_; }
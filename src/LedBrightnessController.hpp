@@ -2,20 +2,22 @@
 #define LED_BRIGHTNESS_CONTROLLER_HPP
 
 #include "Model/LedBrightness.hpp"
+#include "StateStore.hpp"
 
 class LedBrightnessController {
 public:
-  LedBrightnessController();
+  explicit LedBrightnessController(StateStore &stateStore);
 
   void setBrightness(uint8_t brightness);
   void setBrightnessPercent(float percent);
   uint8_t getBrightness() const;
   float getBrightnessPercent() const;
 
-  LedBrightness &getLedBrightness();
+  // Read-only; changes go through the setters so they are published.
   const LedBrightness &getLedBrightness() const;
 
 private:
+  StateStore &stateStore_;
   LedBrightness ledBrightness_;
 };
 
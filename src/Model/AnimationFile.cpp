@@ -9,6 +9,8 @@ void Model::File::serialize(JsonVariant json) const
 
   json["name"] = name;
   json["path"] = path;
+  json["size"] = size;
+  json["modified"] = static_cast<int64_t>(modified);
 }
 
 bool Model::File::deserialize(const JsonObject &object, String &error)
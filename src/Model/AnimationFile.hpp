@@ -9,6 +9,8 @@ namespace Model {
 struct File {
   String name;
   String path;
+  size_t size = 0;
+  time_t modified = 0;
 
   void serialize(JsonVariant json) const;
   bool deserialize(const JsonObject &object, String &error);
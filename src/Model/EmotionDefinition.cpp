@@ -1,7 +1,8 @@
 #include "EmotionDefinition.hpp"
 
 EmotionDefinition::EmotionDefinition()
-    : name(""),
+    : id(0),
+      name(""),
       path(""),
       earColor(Color(0, 0, 0)),
       earGradient(Gradient()),
@@ -10,7 +11,8 @@ EmotionDefinition::EmotionDefinition()
 }
 
 EmotionDefinition::EmotionDefinition(const String &name, const String &path, const Color &earColor, const Gradient &earGradient, ColorMode earColorMode)
-    : name(name),
+    : id(0),
+      name(name),
       path(path),
       earColor(earColor),
       earGradient(earGradient),
@@ -25,6 +27,10 @@ void EmotionDefinition::serialize(JsonVariant object) const
         return;
     }
 
+    if (id != 0)
+    {
+        object["id"] = id;
+    }
     object["name"] = name;
     object["path"] = path;
 
@@ -54,6 +60,10 @@ bool EmotionDefinition::deserialize(const JsonObject &object, String &error)
     }
     path = object["path"].as<String>();
 
+    // Only a hint: EmotionState keeps ids unique and owns their assignment.
+    const int requestedId = object["id"].is<int>() ? object["id"].as<int>() : 0;
+    id = requestedId > 0 && requestedId <= UINT16_MAX ? static_cast<uint16_t>(requestedId) : 0;
+
     if (object["earColorMode"].is<String>())
     {
         String modeStr = object["earColorMode"].as<String>();
@@ -8,6 +8,8 @@
 #include "../Graphics/Gradient.hpp"
   
 struct EmotionDefinition {
+    // Assigned by EmotionState, stable across restarts; 0 means unassigned.
+    uint16_t id;
     String name;
     String path;
     Color earColor;
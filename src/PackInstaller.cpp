@@ -0,0 +1,485 @@
+#include "PackInstaller.hpp"
+
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+constexpr size_t kBlockSize = 512;
+constexpr size_t kNameOffset = 0;
+constexpr size_t kNameLength = 100;
+constexpr size_t kSizeOffset = 124;
+constexpr size_t kSizeLength = 12;
+constexpr size_t kChecksumOffset = 148;
+constexpr size_t kChecksumLength = 8;
+constexpr size_t kTypeOffset = 156;
+constexpr size_t kMagicOffset = 257;
+constexpr size_t kPrefixOffset = 345;
+constexpr size_t kPrefixLength = 155;
+
+String readField(const uint8_t *header, size_t offset, size_t length)
+{
+  const char *field = reinterpret_cast<const char *>(header + offset);
+  size_t used = 0;
+  while (used < length && field[used] != '\0')
+  {
+    used++;
+  }
+
+  String value;
+  value.reserve(used);
+  for (size_t i = 0; i < used; i++)
+  {
+    value += field[i];
+  }
+  return value;
+}
+
+bool parseOctal(const uint8_t *header, size_t offset, size_t length, size_t &value)
+{
+  value = 0;
+  bool seenDigit = false;
+  for (size_t i = 0; i < length; i++)
+  {
+    const char c = static_cast<char>(header[offset + i]);
+    if (c >= '0' && c <= '7')
+    {
+      value = (value << 3) | static_cast<size_t>(c - '0');
+      seenDigit = true;
+    }
+    else if (c == '\0' || c == ' ')
+    {
+      if (seenDigit)
+      {
+        break;
+      }
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Unsigned byte sum of the header with the checksum field counted as spaces.
+size_t headerChecksum(const uint8_t *header)
+{
+  size_t sum = 0;
+  for (size_t i = 0; i < kBlockSize; i++)
+  {
+    const bool inChecksum = i >= kChecksumOffset && i < kChecksumOffset + kChecksumLength;
+    sum += inChecksum ? static_cast<size_t>(' ') : header[i];
+  }
+  return sum;
+}
+
+bool isZeroBlock(const uint8_t *block)
+{
+  for (size_t i = 0; i < kBlockSize; i++)
+  {
+    if (block[i] != 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t paddingFor(size_t size)
+{
+  return (kBlockSize - (size % kBlockSize)) % kBlockSize;
+}
+} // namespace
+
+PackInstaller::PackInstaller(FileManager &fileManager, bool allowAllFileChanges)
+    : fileManager_(fileManager),
+      allowAllFileChanges_(allowAllFileChanges),
+      state_(State::Header),
+      headerFill_(0),
+      entryRemaining_(0),
+      paddingRemaining_(0),
+      zeroBlocks_(0),
+      statusCode_(200),
+      committed_(false)
+{
+}
+
+PackInstaller::~PackInstaller()
+{
+  if (!committed_)
+  {
+    abort();
+  }
+}
+
+bool PackInstaller::write(const uint8_t *data, size_t len)
+{
+  while (len > 0)
+  {
+    switch (state_)
+    {
+    case State::Failed:
+      return false;
+
+    case State::Done:
+      // Trailing zero blocks after the end-of-archive marker are ignored.
+      return true;
+
+    case State::Header:
+    {
+      const size_t toCopy = std::min(len, kBlockSize - headerFill_);
+      memcpy(header_ + headerFill_, data, toCopy);
+      headerFill_ += toCopy;
+      data += toCopy;
+      len -= toCopy;
+      if (headerFill_ == kBlockSize)
+      {
+        headerFill_ = 0;
+        if (!processHeader())
+        {
+          return false;
+        }
+      }
+      break;
+    }
+
+    case State::FileData:
+    case State::EmotionsData:
+    case State::SkipData:
+    {
+      const size_t toConsume = std::min(len, entryRemaining_);
+      if (state_ == State::FileData && !writer_.write(data, toConsume))
+      {
+        return fail(500, F("Failed to write pack entry to flash."));
+      }
+      if (state_ == State::EmotionsData)
+      {
+        emotionsJson_.concat(reinterpret_cast<const char *>(data), toConsume);
+      }
+
+      entryRemaining_ -= toConsume;
+      data += toConsume;
+      len -= toConsume;
+      if (entryRemaining_ == 0 && !finishEntry())
+      {
+        return false;
+      }
+      break;
+    }
+
+    case State::Padding:
+    {
+      const size_t toSkip = std::min(len, paddingRemaining_);
+      paddingRemaining_ -= toSkip;
+      data += toSkip;
+      len -= toSkip;
+      if (paddingRemaining_ == 0)
+      {
+        state_ = State::Header;
+      }
+      break;
+    }
+    }
+  }
+
+  return state_ != State::Failed;
+}
+
+bool PackInstaller::finish(std::vector<EmotionDefinition> &emotions)
+{
+  emotions.clear();
+  if (state_ == State::Failed)
+  {
+    return false;
+  }
+
+  if (state_ != State::Done && !(state_ == State::Header && headerFill_ == 0))
+  {
+    return fail(400, F("Pack ended in the middle of an entry."));
+  }
+
+  if (staged_.empty() && emotionsJson_.isEmpty())
+  {
+    return fail(400, F("Pack contains no files."));
+  }
+
+  if (emotionsJson_.isEmpty())
+  {
+    return true;
+  }
+
+  JsonDocument doc;
+  if (deserializeJson(doc, emotionsJson_) || !doc.is<JsonArray>())
+  {
+    return fail(400, F("'emotions.json' must be a JSON array."));
+  }
+
+  for (JsonObject object : doc.as<JsonArray>())
+  {
+    EmotionDefinition emotion;
+    String error;
+    if (!emotion.deserialize(object, error))
+    {
+      return fail(400, String(F("emotions.json: ")) + error);
+    }
+    emotions.push_back(emotion);
+  }
+
+  return true;
+}
+
+bool PackInstaller::commit()
+{
+  // Existing files are moved aside first so they can be put back if a later rename fails.
+  std::vector<bool> backedUp(staged_.size(), false);
+  for (size_t i = 0; i < staged_.size(); i++)
+  {
+    const String &target = staged_[i].targetPath;
+    if (!fileManager_.exists(target))
+    {
+      continue;
+    }
+
+    const String backup = target + F(".bak");
+    if (fileManager_.exists(backup))
+    {
+      fileManager_.removeFile(backup);
+    }
+    if (!fileManager_.renameFile(target, backup))
+    {
+      error_ = F("Failed to replace existing file.");
+      statusCode_ = 500;
+      break;
+    }
+    backedUp[i] = true;
+  }
+
+  size_t installed = 0;
+  if (error_.isEmpty())
+  {
+    for (; installed < staged_.size(); installed++)
+    {
+      if (!fileManager_.renameFile(staged_[installed].tempPath, staged_[installed].targetPath))
+      {
+        error_ = F("Failed to install pack file.");
+        statusCode_ = 500;
+        break;
+      }
+    }
+  }
+
+  const bool succeeded = error_.isEmpty();
+  for (size_t i = 0; i < staged_.size(); i++)
+  {
+    const String &target = staged_[i].targetPath;
+    const String backup = target + F(".bak");
+    if (succeeded)
+    {
+      if (backedUp[i])
+      {
+        fileManager_.removeFile(backup);
+      }
+      continue;
+    }
+
+    if (i < installed)
+    {
+      fileManager_.removeFile(target);
+    }
+    if (backedUp[i])
+    {
+      fileManager_.renameFile(backup, target);
+    }
+  }
+
+  if (!succeeded)
+  {
+    abort();
+    state_ = State::Failed;
+    return false;
+  }
+
+  staged_.clear();
+  committed_ = true;
+  return true;
+}
+
+void PackInstaller::abort()
+{
+  writer_.abort();
+  for (const auto &file : staged_)
+  {
+    if (fileManager_.exists(file.tempPath))
+    {
+      fileManager_.removeFile(file.tempPath);
+    }
+  }
+  staged_.clear();
+}
+
+const String &PackInstaller::getError() const
+{
+  return error_;
+}
+
+int PackInstaller::getStatusCode() const
+{
+  return statusCode_;
+}
+
+size_t PackInstaller::getFileCount() const
+{
+  return staged_.size();
+}
+
+bool PackInstaller::processHeader()
+{
+  if (isZeroBlock(header_))
+  {
+    // Two zero blocks mark the end of the archive.
+    if (++zeroBlocks_ == 2)
+    {
+      state_ = State::Done;
+    }
+    return true;
+  }
+  zeroBlocks_ = 0;
+
+  if (memcmp(header_ + kMagicOffset, "ustar", 5) != 0)
+  {
+    return fail(400, F("Pack is not a ustar archive."));
+  }
+
+  // A corrupt or truncated upload must not be read as sizes and names.
+  size_t checksum = 0;
+  if (!parseOctal(header_, kChecksumOffset, kChecksumLength, checksum) || checksum != headerChecksum(header_))
+  {
+    return fail(400, F("Pack header checksum mismatch."));
+  }
+
+  size_t size = 0;
+  if (!parseOctal(header_, kSizeOffset, kSizeLength, size))
+  {
+    return fail(400, F("Invalid entry size in pack."));
+  }
+
+  String name = readField(header_, kNameOffset, kNameLength);
+  const String prefix = readField(header_, kPrefixOffset, kPrefixLength);
+  if (!prefix.isEmpty())
+  {
+    name = prefix + "/" + name;
+  }
+
+  return beginEntry(name, static_cast<char>(header_[kTypeOffset]), size);
+}
+
+bool PackInstaller::beginEntry(const String &name, char type, size_t size)
+{
+  entryRemaining_ = size;
+  paddingRemaining_ = paddingFor(size);
+
+  String entryName = name;
+  if (entryName.startsWith("./"))
+  {
+    entryName = entryName.substring(2);
+  }
+
+  const bool isRegularFile = type == '0' || type == '\0';
+  if (!isRegularFile || entryName.isEmpty() || entryName.endsWith("/"))
+  {
+    // Directories, links and pax headers carry nothing to install.
+    state_ = State::SkipData;
+  }
+  else if (entryName == kEmotionsEntryName)
+  {
+    if (size > kMaxEmotionsJsonBytes)
+    {
+      return fail(413, F("'emotions.json' is too large."));
+    }
+    emotionsJson_ = String();
+    emotionsJson_.reserve(size);
+    state_ = State::EmotionsData;
+  }
+  else
+  {
+    if (staged_.size() >= kMaxEntries)
+    {
+      return fail(413, F("Pack contains too many files."));
+    }
+
+    StagedFile file;
+    if (!resolveTargetPath(entryName, file.targetPath))
+    {
+      return fail(400, String(F("Invalid path in pack: ")) + entryName);
+    }
+    for (const auto &staged : staged_)
+    {
+      if (staged.targetPath == file.targetPath)
+      {
+        return fail(400, String(F("Duplicate path in pack: ")) + entryName);
+      }
+    }
+
+    file.tempPath = file.targetPath + F(".tmp");
+    if (fileManager_.exists(file.tempPath) && !fileManager_.removeFile(file.tempPath))
+    {
+      return fail(500, F("Failed to prepare temporary file."));
+    }
+    if (!writer_.open(LittleFS, file.tempPath))
+    {
+      return fail(500, F("Failed to open temporary file."));
+    }
+
+    staged_.push_back(file);
+    state_ = State::FileData;
+  }
+
+  if (entryRemaining_ == 0)
+  {
+    return finishEntry();
+  }
+  return true;
+}
+
+bool PackInstaller::finishEntry()
+{
+  if (state_ == State::FileData && !writer_.close())
+  {
+    return fail(500, F("Failed to write pack entry to flash."));
+  }
+
+  state_ = paddingRemaining_ > 0 ? State::Padding : State::Header;
+  return true;
+}
+
+bool PackInstaller::resolveTargetPath(const String &name, String &targetPath) const
+{
+  if (name.indexOf("..") >= 0 || name.endsWith(".tmp") || name.endsWith(".bak"))
+  {
+    return false;
+  }
+
+  targetPath = name.startsWith("/") ? name : "/" + name;
+  return allowAllFileChanges_ || targetPath.startsWith("/anims/");
+}
+
+bool PackInstaller::fail(int statusCode, const __FlashStringHelper *message)
+{
+  return fail(statusCode, String(message));
+}
+
+bool PackInstaller::fail(int statusCode, const String &message)
+{
+  if (state_ != State::Failed)
+  {
+    error_ = message;
+    statusCode_ = statusCode;
+    state_ = State::Failed;
+  }
+  abort();
+  return false;
+}
@@ -0,0 +1,68 @@
+#ifndef PACK_INSTALLER_HPP
+#define PACK_INSTALLER_HPP
+
+#include <Arduino.h>
+#include <vector>
+
+#include "BufferedFileWriter.hpp"
+#include "FileManager.hpp"
+#include "Model/EmotionDefinition.hpp"
+
+// Unpacks an animation pack (a ustar archive) straight to flash as it streams in.
+// Every file is staged as "<path>.tmp" and only renamed into place by commit(),
+// so a pack that fails half-way never replaces anything that is live.
+// An optional "emotions.json" entry holds an array of EmotionDefinitions.
+class PackInstaller {
+public:
+  static constexpr size_t kMaxEntries = 32;
+  static constexpr size_t kMaxEmotionsJsonBytes = 8 * 1024;
+  static constexpr const char *kEmotionsEntryName = "emotions.json";
+
+  PackInstaller(FileManager &fileManager, bool allowAllFileChanges);
+  ~PackInstaller();
+
+  bool write(const uint8_t *data, size_t len);
+  // Checks the archive ended cleanly and parses the emotions entry.
+  bool finish(std::vector<EmotionDefinition> &emotions);
+  // Moves every staged file into place; on failure the previous files are restored.
+  // Files that are not committed are removed when the installer is destroyed.
+  bool commit();
+  // Removes every staged file.
+  void abort();
+
+  const String &getError() const;
+  int getStatusCode() const;
+  size_t getFileCount() const;
+
+private:
+  enum class State { Header, FileData, EmotionsData, SkipData, Padding, Done, Failed };
+
+  struct StagedFile {
+    String targetPath;
+    String tempPath;
+  };
+
+  bool processHeader();
+  bool beginEntry(const String &name, char type, size_t size);
+  bool finishEntry();
+  bool resolveTargetPath(const String &name, String &targetPath) const;
+  bool fail(int statusCode, const __FlashStringHelper *message);
+  bool fail(int statusCode, const String &message);
+
+  FileManager &fileManager_;
+  bool allowAllFileChanges_;
+  State state_;
+  uint8_t header_[512];
+  size_t headerFill_;
+  size_t entryRemaining_;
+  size_t paddingRemaining_;
+  size_t zeroBlocks_;
+  BufferedFileWriter writer_;
+  String emotionsJson_;
+  std::vector<StagedFile> staged_;
+  String error_;
+  int statusCode_;
+  bool committed_;
+};
+
+#endif // PACK_INSTALLER_HPP
@@ -0,0 +1,415 @@
+#include "SettingsJournal.hpp"
+
+#include <esp_rom_crc.h>
+#include <string.h>
+
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace
+{
+  constexpr uint8_t kMagic[3] = {'P', 'S', 'J'};
+
+  void writeUint16(uint8_t *target, uint16_t value)
+  {
+    target[0] = static_cast<uint8_t>(value);
+    target[1] = static_cast<uint8_t>(value >> 8);
+  }
+
+  void writeUint32(uint8_t *target, uint32_t value)
+  {
+    for (size_t index = 0; index < 4; ++index)
+    {
+      target[index] = static_cast<uint8_t>(value >> (8 * index));
+    }
+  }
+
+  uint16_t readUint16(const uint8_t *source)
+  {
+    return static_cast<uint16_t>(source[0] | (source[1] << 8));
+  }
+
+  uint32_t readUint32(const uint8_t *source)
+  {
+    return static_cast<uint32_t>(source[0]) | (static_cast<uint32_t>(source[1]) << 8) |
+           (static_cast<uint32_t>(source[2]) << 16) | (static_cast<uint32_t>(source[3]) << 24);
+  }
+}
+
+SettingsJournal::SettingsJournal(fs::FS &fs, const char *path)
+    : fs_(fs),
+      path_(path),
+      tempPath_(String(path) + ".tmp"),
+      writingSnapshot_(false),
+      tailDamaged_(false),
+      generation_(0),
+      size_(0),
+      pendingBytes_(0),
+      pendingRecords_(0),
+      appendedRecords_(0),
+      compactions_(0),
+      discardedTails_(0)
+{
+}
+
+bool SettingsJournal::exists() const
+{
+  return fs_.exists(path_);
+}
+
+bool SettingsJournal::replay(const RecordHandler &handler)
+{
+  recoverSnapshot();
+
+  if (!fs_.exists(path_))
+  {
+    return false;
+  }
+
+  bool complete = false;
+  size_t validBytes = 0;
+  size_t fileSize = 0;
+  uint32_t generation = 0;
+  if (!scan(path_, handler, generation, complete, validBytes, fileSize))
+  {
+    Serial.println(F("[E] Settings journal header is invalid."));
+    return false;
+  }
+
+  generation_ = generation;
+  size_ = validBytes;
+  tailDamaged_ = validBytes < fileSize;
+  if (tailDamaged_)
+  {
+    ++discardedTails_;
+    Serial.printf("[W] Settings journal: ignored %u damaged bytes at the end.\n",
+                  static_cast<unsigned>(fileSize - validBytes));
+  }
+  return true;
+}
+
+bool SettingsJournal::beginAppend()
+{
+  abort();
+
+  // Records written after a damaged tail would never be replayed.
+  if (tailDamaged_ || !fs_.exists(path_))
+  {
+    return false;
+  }
+
+  file_ = fs_.open(path_, FILE_APPEND);
+  if (!file_)
+  {
+    return false;
+  }
+  writingSnapshot_ = false;
+  pendingBytes_ = 0;
+  pendingRecords_ = 0;
+  return true;
+}
+
+bool SettingsJournal::beginSnapshot()
+{
+  abort();
+
+  file_ = fs_.open(tempPath_, FILE_WRITE);
+  if (!file_)
+  {
+    return false;
+  }
+  writingSnapshot_ = true;
+  pendingBytes_ = 0;
+  pendingRecords_ = 0;
+  if (!writeHeader(file_, generation_ + 1))
+  {
+    abort();
+    return false;
+  }
+  pendingBytes_ = kHeaderSize;
+  return true;
+}
+
+bool SettingsJournal::append(RecordType type, const uint8_t *payload, size_t length)
+{
+  if (!file_ || length > kMaxPayloadBytes)
+  {
+    return false;
+  }
+
+  uint8_t header[kRecordHeaderSize];
+  header[0] = static_cast<uint8_t>(type);
+  header[1] = 0;
+  writeUint16(header + 2, static_cast<uint16_t>(length));
+
+  uint8_t trailer[kRecordCrcSize];
+  uint32_t crc = esp_rom_crc32_le(0, header, sizeof(header));
+  crc = esp_rom_crc32_le(crc, payload, length);
+  writeUint32(trailer, crc);
+
+  const bool written = file_.write(header, sizeof(header)) == sizeof(header) &&
+                       (length == 0 || file_.write(payload, length) == length) &&
+                       file_.write(trailer, sizeof(trailer)) == sizeof(trailer);
+  if (!written)
+  {
+    if (!writingSnapshot_)
+    {
+      // Part of a record may have reached flash; compact before appending again.
+      tailDamaged_ = true;
+    }
+    abort();
+    return false;
+  }
+
+  pendingBytes_ += sizeof(header) + length + sizeof(trailer);
+  ++pendingRecords_;
+  return true;
+}
+
+bool SettingsJournal::append(RecordType type, const String &payload)
+{
+  return append(type, reinterpret_cast<const uint8_t *>(payload.c_str()), payload.length());
+}
+
+bool SettingsJournal::commit()
+{
+  if (!file_)
+  {
+    return false;
+  }
+
+  if (!writingSnapshot_)
+  {
+    file_.close();
+    size_ += pendingBytes_;
+    appendedRecords_ += pendingRecords_;
+    return true;
+  }
+
+  if (!append(RecordType::SnapshotEnd, nullptr, 0))
+  {
+    return false;
+  }
+  file_.close();
+  writingSnapshot_ = false;
+
+  // The complete snapshot already exists under the temp name, so a power cut
+  // between these two calls is finished by recoverSnapshot() on next boot.
+  fs_.remove(path_);
+  if (!fs_.rename(tempPath_, path_))
+  {
+    Serial.println(F("[E] Could not replace the settings journal."));
+    return false;
+  }
+
+  ++generation_;
+  size_ = pendingBytes_;
+  appendedRecords_ += pendingRecords_;
+  tailDamaged_ = false;
+  ++compactions_;
+  return true;
+}
+
+void SettingsJournal::abort()
+{
+  if (file_)
+  {
+    file_.close();
+  }
+  if (writingSnapshot_)
+  {
+    fs_.remove(tempPath_);
+    writingSnapshot_ = false;
+  }
+  pendingBytes_ = 0;
+  pendingRecords_ = 0;
+}
+
+bool SettingsJournal::needsCompaction() const
+{
+  return tailDamaged_ || size_ >= kCompactThresholdBytes || !fs_.exists(path_);
+}
+
+uint32_t SettingsJournal::getGeneration() const
+{
+  return generation_;
+}
+
+size_t SettingsJournal::getSize() const
+{
+  return size_;
+}
+
+uint32_t SettingsJournal::getAppendedRecords() const
+{
+  return appendedRecords_;
+}
+
+uint32_t SettingsJournal::getCompactions() const
+{
+  return compactions_;
+}
+
+uint32_t SettingsJournal::getDiscardedTails() const
+{
+  return discardedTails_;
+}
+
+bool SettingsJournal::readHeader(File &file, uint32_t &generation) const
+{
+  uint8_t header[kHeaderSize];
+  return file.read(header, sizeof(header)) == sizeof(header) && parseHeader(header, generation);
+}
+
+bool SettingsJournal::parseHeader(const uint8_t *header, uint32_t &generation) const
+{
+  if (memcmp(header, kMagic, sizeof(kMagic)) != 0 || header[3] != kVersion)
+  {
+    return false;
+  }
+  if (esp_rom_crc32_le(0, header, 8) != readUint32(header + 8))
+  {
+    return false;
+  }
+  generation = readUint32(header + 4);
+  return true;
+}
+
+bool SettingsJournal::writeHeader(File &file, uint32_t generation)
+{
+  uint8_t header[kHeaderSize];
+  memcpy(header, kMagic, sizeof(kMagic));
+  header[3] = kVersion;
+  writeUint32(header + 4, generation);
+  writeUint32(header + 8, esp_rom_crc32_le(0, header, 8));
+  return file.write(header, sizeof(header)) == sizeof(header);
+}
+
+bool SettingsJournal::scan(const String &path, const RecordHandler &handler, uint32_t &generation,
+                           bool &complete, size_t &validBytes, size_t &fileSize) const
+{
+  complete = false;
+  validBytes = 0;
+  fileSize = 0;
+
+  File file = fs_.open(path, FILE_READ);
+  if (!file)
+  {
+    return false;
+  }
+  fileSize = file.size();
+
+  // The whole journal is normally pulled in with one read and the records are
+  // handed out in place; record-by-record reads are only the low-memory path.
+  std::unique_ptr<uint8_t[]> contents(new (std::nothrow) uint8_t[fileSize]);
+  const bool buffered = contents && file.read(contents.get(), fileSize) == fileSize;
+  std::vector<uint8_t> payloadBuffer;
+  if (!buffered)
+  {
+    contents.reset();
+    file.seek(0);
+    payloadBuffer.resize(kMaxPayloadBytes);
+  }
+
+  // Returns the next `length` bytes, read into `target` when not buffered.
+  size_t offset = 0;
+  auto next = [&](size_t length, uint8_t *target) -> const uint8_t *
+  {
+    if (fileSize - offset < length)
+    {
+      return nullptr;
+    }
+    offset += length;
+    if (buffered)
+    {
+      return contents.get() + offset - length;
+    }
+    return file.read(target, length) == length ? target : nullptr;
+  };
+
+  uint8_t headerBuffer[kHeaderSize];
+  const uint8_t *fileHeader = next(kHeaderSize, headerBuffer);
+  if (fileHeader == nullptr || !parseHeader(fileHeader, generation))
+  {
+    file.close();
+    return false;
+  }
+  validBytes = kHeaderSize;
+
+  uint8_t recordHeaderBuffer[kRecordHeaderSize];
+  uint8_t trailerBuffer[kRecordCrcSize];
+  while (true)
+  {
+    const uint8_t *header = next(kRecordHeaderSize, recordHeaderBuffer);
+    if (header == nullptr)
+    {
+      break;
+    }
+    const size_t length = readUint16(header + 2);
+    if (length > kMaxPayloadBytes)
+    {
+      break;
+    }
+    const uint8_t *payload = next(length, payloadBuffer.data());
+    const uint8_t *trailer = payload != nullptr ? next(kRecordCrcSize, trailerBuffer) : nullptr;
+    if (trailer == nullptr)
+    {
+      break;
+    }
+
+    uint32_t crc = esp_rom_crc32_le(0, header, kRecordHeaderSize);
+    crc = esp_rom_crc32_le(crc, payload, length);
+    if (crc != readUint32(trailer))
+    {
+      break;
+    }
+
+    validBytes += kRecordHeaderSize + length + kRecordCrcSize;
+    const RecordType type = static_cast<RecordType>(header[0]);
+    if (type == RecordType::SnapshotEnd)
+    {
+      complete = true;
+    }
+    else if (handler)
+    {
+      handler(type, payload, length);
+    }
+  }
+
+  file.close();
+  return true;
+}
+
+void SettingsJournal::recoverSnapshot()
+{
+  if (!fs_.exists(tempPath_))
+  {
+    return;
+  }
+
+  uint32_t tempGeneration = 0;
+  bool complete = false;
+  size_t validBytes = 0;
+  size_t fileSize = 0;
+  const bool tempValid = scan(tempPath_, nullptr, tempGeneration, complete, validBytes, fileSize) && complete;
+
+  uint32_t currentGeneration = 0;
+  bool currentValid = false;
+  if (fs_.exists(path_))
+  {
+    File file = fs_.open(path_, FILE_READ);
+    currentValid = file && readHeader(file, currentGeneration);
+    file.close();
+  }
+
+  if (tempValid && (!currentValid || tempGeneration > currentGeneration))
+  {
+    Serial.println(F("[I] Finishing interrupted settings compaction."));
+    fs_.remove(path_);
+    fs_.rename(tempPath_, path_);
+    return;
+  }
+
+  fs_.remove(tempPath_);
+}
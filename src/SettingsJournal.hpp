@@ -0,0 +1,98 @@
+#ifndef SETTINGS_JOURNAL_HPP
+#define SETTINGS_JOURNAL_HPP
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include <functional>
+
+// Append-only binary log of settings records. Every save appends only the
+// values that changed; once the log grows past kCompactThresholdBytes it is
+// rewritten as a snapshot of the current state under the next generation.
+//
+// File layout (little endian):
+//   header: 'P' 'S' 'J' version(u8) generation(u32) crc32(u32 of the first 8 bytes)
+//   record: type(u8) reserved(u8) length(u16) payload[length] crc32(u32 of type..payload)
+//
+// Replay stops at the first truncated or corrupt record, so a power cut while
+// appending loses at most the record being written. Compaction writes the
+// snapshot to a temp file ending in a SnapshotEnd record; a temp file without
+// one is discarded on the next boot.
+class SettingsJournal
+{
+public:
+  enum class RecordType : uint8_t
+  {
+    Brightness = 1,
+    FanDutyCycle = 2,
+    CurrentEmotion = 3,
+    // MessagePack emotion written by earlier firmware; still replayed.
+    EmotionUpsertMsgPack = 4,
+    EmotionRemove = 5,
+    EmotionsReset = 6,
+    SnapshotEnd = 7,
+    // Fixed binary layout, see SettingsStorage.
+    EmotionUpsert = 8,
+  };
+
+  using RecordHandler = std::function<void(RecordType type, const uint8_t *payload, size_t length)>;
+
+  static constexpr size_t kMaxPayloadBytes = 1024;
+  static constexpr size_t kCompactThresholdBytes = 16 * 1024;
+
+  SettingsJournal(fs::FS &fs, const char *path);
+
+  bool exists() const;
+  // Finishes or discards an interrupted compaction, then feeds every valid
+  // record to the handler. Returns false when there is no usable journal.
+  bool replay(const RecordHandler &handler);
+
+  // Starts a batch appended to the current generation.
+  bool beginAppend();
+  // Starts a snapshot that replaces the journal once committed.
+  bool beginSnapshot();
+  bool append(RecordType type, const uint8_t *payload, size_t length);
+  bool append(RecordType type, const String &payload);
+  bool commit();
+  void abort();
+
+  // True when the log is large enough (or its tail is damaged) to rewrite.
+  bool needsCompaction() const;
+
+  uint32_t getGeneration() const;
+  size_t getSize() const;
+  uint32_t getAppendedRecords() const;
+  uint32_t getCompactions() const;
+  uint32_t getDiscardedTails() const;
+
+private:
+  static constexpr uint8_t kVersion = 1;
+  static constexpr size_t kHeaderSize = 12;
+  static constexpr size_t kRecordHeaderSize = 4;
+  static constexpr size_t kRecordCrcSize = 4;
+
+  bool readHeader(File &file, uint32_t &generation) const;
+  bool parseHeader(const uint8_t *header, uint32_t &generation) const;
+  bool writeHeader(File &file, uint32_t generation);
+  // Returns false if the file is not a valid journal. `complete` reports
+  // whether a SnapshotEnd record was reached, `validBytes` the intact prefix.
+  bool scan(const String &path, const RecordHandler &handler, uint32_t &generation,
+            bool &complete, size_t &validBytes, size_t &fileSize) const;
+  void recoverSnapshot();
+
+  fs::FS &fs_;
+  String path_;
+  String tempPath_;
+  File file_;
+  bool writingSnapshot_;
+  bool tailDamaged_;
+  uint32_t generation_;
+  size_t size_;
+  size_t pendingBytes_;
+  uint32_t pendingRecords_;
+  uint32_t appendedRecords_;
+  uint32_t compactions_;
+  uint32_t discardedTails_;
+};
+
+#endif // SETTINGS_JOURNAL_HPP
@@ -3,6 +3,213 @@
 #include <ArduinoJson.h>
 #include <FS.h>
 #include <LittleFS.h>
+#include <esp_system.h>
+#include <string.h>
+
+#include "HeapMonitor.hpp"
+
+namespace
+{
+  using RecordType = SettingsJournal::RecordType;
+
+  void writeInt32(uint8_t *target, int32_t value)
+  {
+    const uint32_t bits = static_cast<uint32_t>(value);
+    for (size_t index = 0; index < 4; ++index)
+    {
+      target[index] = static_cast<uint8_t>(bits >> (8 * index));
+    }
+  }
+
+  int32_t readInt32(const uint8_t *source)
+  {
+    return static_cast<int32_t>(static_cast<uint32_t>(source[0]) | (static_cast<uint32_t>(source[1]) << 8) |
+                                (static_cast<uint32_t>(source[2]) << 16) | (static_cast<uint32_t>(source[3]) << 24));
+  }
+
+  String payloadToString(const uint8_t *payload, size_t length)
+  {
+    String value;
+    value.concat(reinterpret_cast<const char *>(payload), length);
+    return value;
+  }
+
+  // Emotion record: colorMode(u8) earColor(rgb) gradientFrom(rgb) gradientTo(rgb)
+  // angle(f32) midpoint(f32) nameLength(u16) name pathLength(u16) path id(u16).
+  // The id is missing from records written before emotions had ids.
+  // Restoring it is a handful of copies, no hex parsing or JSON tree.
+  constexpr size_t kEmotionRecordFixedBytes = 24;
+
+  void appendColor(std::vector<uint8_t> &packed, const Color &color)
+  {
+    packed.push_back(color.getRed());
+    packed.push_back(color.getGreen());
+    packed.push_back(color.getBlue());
+  }
+
+  void appendFloat(std::vector<uint8_t> &packed, float value)
+  {
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t bytes[4];
+    writeInt32(bytes, static_cast<int32_t>(bits));
+    packed.insert(packed.end(), bytes, bytes + sizeof(bytes));
+  }
+
+  void appendString(std::vector<uint8_t> &packed, const String &value)
+  {
+    const uint16_t length = static_cast<uint16_t>(value.length());
+    packed.push_back(static_cast<uint8_t>(length));
+    packed.push_back(static_cast<uint8_t>(length >> 8));
+    packed.insert(packed.end(), value.c_str(), value.c_str() + length);
+  }
+
+  std::vector<uint8_t> packEmotion(const EmotionDefinition &emotion)
+  {
+    std::vector<uint8_t> packed;
+    packed.reserve(kEmotionRecordFixedBytes + emotion.name.length() + emotion.path.length());
+    packed.push_back(emotion.earColorMode == ColorMode::Gradient ? 1 : 0);
+    appendColor(packed, emotion.earColor);
+    appendColor(packed, emotion.earGradient.from);
+    appendColor(packed, emotion.earGradient.to);
+    appendFloat(packed, emotion.earGradient.angle);
+    appendFloat(packed, emotion.earGradient.midpoint);
+    appendString(packed, emotion.name);
+    appendString(packed, emotion.path);
+    packed.push_back(static_cast<uint8_t>(emotion.id));
+    packed.push_back(static_cast<uint8_t>(emotion.id >> 8));
+    return packed;
+  }
+
+  class PayloadReader
+  {
+  public:
+    PayloadReader(const uint8_t *payload, size_t length) : payload_(payload), length_(length), offset_(0) {}
+
+    bool readByte(uint8_t &value)
+    {
+      if (offset_ >= length_)
+      {
+        return false;
+      }
+      value = payload_[offset_++];
+      return true;
+    }
+
+    bool readColor(Color &color)
+    {
+      uint8_t red = 0;
+      uint8_t green = 0;
+      uint8_t blue = 0;
+      if (!readByte(red) || !readByte(green) || !readByte(blue))
+      {
+        return false;
+      }
+      color.set(red, green, blue);
+      return true;
+    }
+
+    bool readFloat(float &value)
+    {
+      if (length_ - offset_ < 4)
+      {
+        return false;
+      }
+      const uint32_t bits = static_cast<uint32_t>(readInt32(payload_ + offset_));
+      memcpy(&value, &bits, sizeof(value));
+      offset_ += 4;
+      return true;
+    }
+
+    bool readUint16(uint16_t &value)
+    {
+      uint8_t low = 0;
+      uint8_t high = 0;
+      if (!readByte(low) || !readByte(high))
+      {
+        return false;
+      }
+      value = static_cast<uint16_t>(low | (high << 8));
+      return true;
+    }
+
+    bool readString(String &value)
+    {
+      uint16_t length = 0;
+      if (!readUint16(length))
+      {
+        return false;
+      }
+      if (length_ - offset_ < length)
+      {
+        return false;
+      }
+      value = payloadToString(payload_ + offset_, length);
+      offset_ += length;
+      return true;
+    }
+
+    bool atEnd() const
+    {
+      return offset_ == length_;
+    }
+
+  private:
+    const uint8_t *payload_;
+    size_t length_;
+    size_t offset_;
+  };
+
+  bool unpackEmotion(const uint8_t *payload, size_t length, EmotionDefinition &emotion, String &error)
+  {
+    PayloadReader reader(payload, length);
+    uint8_t colorMode = 0;
+    const bool valid = reader.readByte(colorMode) &&
+                       reader.readColor(emotion.earColor) &&
+                       reader.readColor(emotion.earGradient.from) &&
+                       reader.readColor(emotion.earGradient.to) &&
+                       reader.readFloat(emotion.earGradient.angle) &&
+                       reader.readFloat(emotion.earGradient.midpoint) &&
+                       reader.readString(emotion.name) &&
+                       reader.readString(emotion.path) &&
+                       (reader.atEnd() || reader.readUint16(emotion.id)) &&
+                       reader.atEnd();
+    if (!valid)
+    {
+      error = F("Malformed emotion record.");
+      return false;
+    }
+    emotion.earColorMode = colorMode == 1 ? ColorMode::Gradient : ColorMode::Solid;
+    return true;
+  }
+
+  bool unpackMsgPackEmotion(const uint8_t *payload, size_t length, EmotionDefinition &emotion, String &error)
+  {
+    JsonDocument document;
+    const DeserializationError parseError = deserializeMsgPack(document, payload, length);
+    if (parseError)
+    {
+      error = parseError.c_str();
+      return false;
+    }
+    return emotion.deserialize(document.as<JsonObject>(), error);
+  }
+
+  template <typename T>
+  int findByName(const std::vector<T> &items, const String &name)
+  {
+    for (size_t index = 0; index < items.size(); ++index)
+    {
+      if (items[index].name == name)
+      {
+        return static_cast<int>(index);
+      }
+    }
+    return -1;
+  }
+}
+
+SettingsStorage *SettingsStorage::instance_ = nullptr;
 
 SettingsStorage::SettingsStorage(EmotionState &emotionState,
                                  FanController &fanController,
@@ -11,18 +218,170 @@ SettingsStorage::SettingsStorage(EmotionState &emotionState,
     : emotionState_(emotionState),
       fanController_(fanController),
       brightnessController_(brightnessController),
-      earController_(earController)
+      earController_(earController),
+      journal_(LittleFS, kJournalPath),
+      dirty_(false),
+      firstChangeMillis_(0),
+      lastChangeMillis_(0),
+      changeCount_(0),
+      writeCount_(0),
+      failedWriteCount_(0),
+      lastWriteMillis_(0),
+      lastWriteDurationMs_(0),
+      maxWriteDurationMs_(0)
 {
+  instance_ = this;
+  esp_register_shutdown_handler(flushOnShutdown);
 }
 
 bool SettingsStorage::load()
 {
+  HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Settings);
+
+  if (loadJournal())
+  {
+    return true;
+  }
+
   if (!LittleFS.exists(kSettingsPath))
   {
     Serial.println(F("[I] No settings file found. Using defaults."));
     return true;
   }
 
+  if (!loadJson())
+  {
+    return false;
+  }
+
+  // From here on the journal is authoritative; keeping the JSON around would
+  // only let a stale copy win if the journal were ever lost.
+  if (save())
+  {
+    LittleFS.remove(kSettingsPath);
+    Serial.println(F("[I] Migrated settings.json to the settings journal."));
+  }
+  return true;
+}
+
+bool SettingsStorage::loadJournal()
+{
+  const uint32_t startMicros = micros();
+  std::vector<EmotionDefinition> emotions;
+  bool hasEmotions = false;
+  bool hasBrightness = false;
+  bool hasFanDutyCycle = false;
+  bool hasCurrentEmotion = false;
+  uint8_t brightness = 0;
+  int fanDutyCycle = 0;
+  String currentEmotion;
+
+  const bool replayed = journal_.replay([&](RecordType type, const uint8_t *payload, size_t length)
+                                        {
+    switch (type)
+    {
+    case RecordType::Brightness:
+      if (length == 1)
+      {
+        brightness = payload[0];
+        hasBrightness = true;
+      }
+      break;
+    case RecordType::FanDutyCycle:
+      if (length == 4)
+      {
+        fanDutyCycle = readInt32(payload);
+        hasFanDutyCycle = true;
+      }
+      break;
+    case RecordType::CurrentEmotion:
+      currentEmotion = payloadToString(payload, length);
+      hasCurrentEmotion = true;
+      break;
+    case RecordType::EmotionsReset:
+      emotions.clear();
+      hasEmotions = true;
+      break;
+    case RecordType::EmotionUpsert:
+    case RecordType::EmotionUpsertMsgPack:
+    {
+      EmotionDefinition emotion;
+      String error;
+      const bool unpacked = type == RecordType::EmotionUpsert
+                                ? unpackEmotion(payload, length, emotion, error)
+                                : unpackMsgPackEmotion(payload, length, emotion, error);
+      if (!unpacked)
+      {
+        Serial.printf("[W] Skipping invalid emotion in settings journal: %s\n", error.c_str());
+        break;
+      }
+      const int index = findByName(emotions, emotion.name);
+      if (index >= 0)
+      {
+        emotions[index] = emotion;
+      }
+      else
+      {
+        emotions.push_back(emotion);
+      }
+      hasEmotions = true;
+      break;
+    }
+    case RecordType::EmotionRemove:
+    {
+      const int index = findByName(emotions, payloadToString(payload, length));
+      if (index >= 0)
+      {
+        emotions.erase(emotions.begin() + index);
+      }
+      hasEmotions = true;
+      break;
+    }
+    default:
+      // Written by newer firmware; skipped so a downgrade still boots.
+      break;
+    } });
+
+  if (!replayed)
+  {
+    return false;
+  }
+
+  const auto emotionLock = emotionState_.lock();
+  if (hasEmotions)
+  {
+    emotionState_.seedEmotionDefinitions(emotions);
+  }
+  if (hasCurrentEmotion)
+  {
+    emotionState_.setCurrentEmotion(currentEmotion);
+  }
+  if (hasFanDutyCycle && !fanController_.setDutyCycle(fanDutyCycle))
+  {
+    Serial.printf("[W] Ignoring invalid fan dutyCycle in settings journal: %d\n", fanDutyCycle);
+  }
+  if (hasBrightness)
+  {
+    brightnessController_.setBrightness(brightness);
+  }
+
+  earController_.applyEmotionEarColor(emotionState_.getCurrentEmotionDefinition());
+
+  persisted_ = captureState();
+  if (journal_.needsCompaction())
+  {
+    markDirty();
+  }
+
+  Serial.printf("[I] Settings loaded from journal (generation %lu, %u bytes) in %lu us.\n",
+                static_cast<unsigned long>(journal_.getGeneration()),
+                static_cast<unsigned>(journal_.getSize()),
+                static_cast<unsigned long>(micros() - startMicros));
+  return true;
+}
+
+bool SettingsStorage::loadJson()
+{
   File file = LittleFS.open(kSettingsPath, FILE_READ);
   if (!file)
   {
@@ -40,92 +399,382 @@ bool SettingsStorage::load()
     return false;
   }
 
-  if (document["emotions"].is<JsonArray>())
+  String importError;
+  if (!importJson(document.as<JsonObject>(), importError))
+  {
+    Serial.printf("[E] Invalid settings: %s\n", importError.c_str());
+    return false;
+  }
+
+  Serial.println(F("[I] Settings loaded from settings.json."));
+  return true;
+}
+
+void SettingsStorage::exportJson(JsonVariant json) const
+{
+  JsonObject brightnessObject = json["brightness"].to<JsonObject>();
+  brightnessController_.getLedBrightness().serialize(brightnessObject);
+
+  const auto emotionLock = emotionState_.lock();
+  JsonArray emotionsArray = json["emotions"].to<JsonArray>();
+  for (const auto &emotion : emotionState_.getEmotionDefinitions())
+  {
+    JsonObject emotionObject = emotionsArray.add<JsonObject>();
+    emotion.serialize(emotionObject);
+  }
+
+  json["currentEmotion"] = emotionState_.getCurrentEmotion();
+
+  JsonObject fanObject = json["fan"].to<JsonObject>();
+  fanObject["dutyCycle"] = fanController_.getDutyCycle();
+}
+
+bool SettingsStorage::importJson(const JsonObject &object, String &error)
+{
+  // Everything is validated before anything is applied.
+  std::vector<EmotionDefinition> emotions;
+  const bool hasEmotions = object["emotions"].is<JsonArray>();
+  if (hasEmotions)
   {
-    std::vector<EmotionDefinition> loadedEmotions;
-    for (JsonObject emotionObject : document["emotions"].as<JsonArray>())
+    for (JsonObject emotionObject : object["emotions"].as<JsonArray>())
     {
       EmotionDefinition emotion;
-      String emotionError;
-      if (!emotion.deserialize(emotionObject, emotionError))
+      if (!emotion.deserialize(emotionObject, error))
       {
-        Serial.printf("[E] Invalid emotion in settings: %s\n", emotionError.c_str());
         return false;
       }
-      loadedEmotions.push_back(emotion);
+      if (findByName(emotions, emotion.name) >= 0)
+      {
+        error = "Duplicate emotion name: " + emotion.name;
+        return false;
+      }
+      emotions.push_back(emotion);
     }
-    emotionState_.seedEmotionDefinitions(loadedEmotions);
   }
 
-  if (document["currentEmotion"].is<String>())
+  const bool hasFanDutyCycle = object["fan"]["dutyCycle"].is<int>();
+  const int fanDutyCycle = object["fan"]["dutyCycle"].as<int>();
+  if (hasFanDutyCycle && (fanDutyCycle < 0 || fanDutyCycle > fanController_.getMaxDutyCycle()))
   {
-    emotionState_.setCurrentEmotion(document["currentEmotion"].as<String>());
+    error = "Invalid fan dutyCycle: " + String(fanDutyCycle);
+    return false;
   }
 
-  if (document["fan"].is<JsonObject>())
+  LedBrightness brightness = brightnessController_.getLedBrightness();
+  if (object["brightness"].is<JsonObject>() &&
+      !brightness.deserialize(object["brightness"].as<JsonObject>(), error))
   {
-    JsonObject fan = document["fan"].as<JsonObject>();
-    if (fan["dutyCycle"].is<int>())
-    {
-      const int dutyCycle = fan["dutyCycle"].as<int>();
-      if (!fanController_.setDutyCycle(dutyCycle))
-      {
-        Serial.printf("[E] Invalid fan dutyCycle in settings: %d\n", dutyCycle);
-        return false;
-      }
-    }
+    return false;
   }
 
-  if (document["brightness"].is<JsonObject>())
+  // Held until the ear color is applied, so a concurrent edit cannot slip in
+  // between seeding and reading the current definition back.
+  const auto emotionLock = emotionState_.lock();
+  if (hasEmotions)
   {
-    String earError;
-    if (!brightnessController_.getLedBrightness().deserialize(document["brightness"].as<JsonObject>(), earError))
-    {
-      Serial.printf("[E] Invalid brightness settings: %s\n", earError.c_str());
-      return false;
-    }
+    emotionState_.seedEmotionDefinitions(emotions);
+  }
+  if (object["currentEmotion"].is<String>())
+  {
+    emotionState_.setCurrentEmotion(object["currentEmotion"].as<String>());
   }
+  if (hasFanDutyCycle)
+  {
+    fanController_.setDutyCycle(fanDutyCycle);
+  }
+  brightnessController_.setBrightness(brightness.getBrightness());
 
   earController_.applyEmotionEarColor(emotionState_.getCurrentEmotionDefinition());
+  return true;
+}
+
+void SettingsStorage::markDirty()
+{
+  const uint32_t now = millis();
+  lastChangeMillis_ = now;
+  if (!dirty_.exchange(true))
+  {
+    firstChangeMillis_ = now;
+  }
+  ++changeCount_;
+}
+
+void SettingsStorage::update()
+{
+  if (!dirty_)
+  {
+    return;
+  }
+
+  const uint32_t now = millis();
+  const bool settled = now - lastChangeMillis_ >= kSaveDelayMs;
+  const bool overdue = now - firstChangeMillis_ >= kMaxSaveLatencyMs;
+  if (settled || overdue)
+  {
+    flush();
+  }
+}
+
+bool SettingsStorage::flush()
+{
+  // Changes marked while writing keep the flag set and are written next time.
+  if (!dirty_.exchange(false))
+  {
+    return true;
+  }
 
-  Serial.println(F("[I] Settings loaded."));
+  if (!save())
+  {
+    markDirty();
+    return false;
+  }
   return true;
 }
 
-bool SettingsStorage::save() const
+bool SettingsStorage::isDirty() const
 {
-  JsonDocument document;
+  return dirty_;
+}
 
-  JsonObject brightnessObject = document["brightness"].to<JsonObject>();
-  brightnessController_.getLedBrightness().serialize(brightnessObject);
+void SettingsStorage::serializeStats(JsonVariant json) const
+{
+  const uint32_t changes = changeCount_;
+  json["changes"] = changes;
+  json["flashWrites"] = writeCount_;
+  json["failedWrites"] = failedWriteCount_;
+  json["coalescedChanges"] = changes > writeCount_ ? changes - writeCount_ : 0;
+  json["dirty"] = isDirty();
+  json["lastWriteMillis"] = lastWriteMillis_;
+  json["lastWriteDurationMs"] = lastWriteDurationMs_;
+  json["maxWriteDurationMs"] = maxWriteDurationMs_;
+  json["saveDelayMs"] = kSaveDelayMs;
+  json["maxSaveLatencyMs"] = kMaxSaveLatencyMs;
+
+  JsonObject journal = json["journal"].to<JsonObject>();
+  journal["bytes"] = journal_.getSize();
+  journal["generation"] = journal_.getGeneration();
+  journal["records"] = journal_.getAppendedRecords();
+  journal["compactions"] = journal_.getCompactions();
+  journal["discardedTails"] = journal_.getDiscardedTails();
+  journal["compactThresholdBytes"] = SettingsJournal::kCompactThresholdBytes;
+}
+
+void SettingsStorage::flushOnShutdown()
+{
+  // Known restarts (OTA) flush beforehand. This is the last chance for any
+  // other one, and it must not wait: a task holding either lock may never run
+  // again, so the write is skipped rather than deadlocking esp_restart().
+  if (instance_ == nullptr || !instance_->isDirty())
+  {
+    return;
+  }
+
+  std::unique_lock<std::mutex> saveLock(instance_->saveMutex_, std::try_to_lock);
+  const auto emotionLock = instance_->emotionState_.tryLock();
+  if (!saveLock.owns_lock() || !emotionLock.owns_lock())
+  {
+    Serial.println(F("[W] Settings busy at shutdown, pending changes not saved."));
+    return;
+  }
+
+  instance_->dirty_ = false;
+  instance_->saveLocked();
+}
+
+bool SettingsStorage::save()
+{
+  std::lock_guard<std::mutex> lock(saveMutex_);
+  return saveLocked();
+}
+
+bool SettingsStorage::saveLocked()
+{
+  HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Settings);
+  const uint32_t startMillis = millis();
+
+  const PersistedState state = captureState();
+
+  size_t records = 0;
+  bool compacted = false;
+  bool written = persisted_.valid && !journal_.needsCompaction() && appendChanges(state, records);
+  if (!written || journal_.needsCompaction())
+  {
+    written = writeSnapshot(state);
+    compacted = written;
+  }
+
+  if (!written)
+  {
+    Serial.println(F("[E] Failed to write settings journal."));
+    ++failedWriteCount_;
+    return false;
+  }
 
-  JsonArray emotionsArray = document["emotions"].to<JsonArray>();
+  persisted_ = state;
+  if (records == 0 && !compacted)
+  {
+    return true;
+  }
+
+  ++writeCount_;
+  lastWriteMillis_ = millis();
+  lastWriteDurationMs_ = lastWriteMillis_ - startMillis;
+  if (lastWriteDurationMs_ > maxWriteDurationMs_)
+  {
+    maxWriteDurationMs_ = lastWriteDurationMs_;
+  }
+
+  if (compacted)
+  {
+    Serial.printf("[I] Settings saved (journal generation %lu).\n",
+                  static_cast<unsigned long>(journal_.getGeneration()));
+  }
+  else
+  {
+    Serial.printf("[I] Settings saved (%u journal records).\n", static_cast<unsigned>(records));
+  }
+  return true;
+}
+
+SettingsStorage::PersistedState SettingsStorage::captureState() const
+{
+  PersistedState state;
+  state.valid = true;
+  state.brightness = brightnessController_.getLedBrightness().getBrightness();
+  state.fanDutyCycle = fanController_.getDutyCycle();
+  // The web server and BLE edit emotions while the loop saves; the copy is
+  // taken under their lock so it never sees a half-applied change.
+  const auto emotionLock = emotionState_.lock();
+  state.currentEmotion = emotionState_.getCurrentEmotion();
   for (const auto &emotion : emotionState_.getEmotionDefinitions())
   {
-    JsonObject emotionObject = emotionsArray.add<JsonObject>();
-    emotion.serialize(emotionObject);
+    state.emotions.push_back({emotion.name, packEmotion(emotion)});
   }
+  return state;
+}
 
-  document["currentEmotion"] = emotionState_.getCurrentEmotion();
+bool SettingsStorage::appendChanges(const PersistedState &state, size_t &records)
+{
+  records = 0;
 
-  JsonObject fanObject = document["fan"].to<JsonObject>();
-  fanObject["dutyCycle"] = fanController_.getDutyCycle();
+  // Replay appends new emotions at the end. If that would not reproduce the
+  // current order (e.g. after a reorder), only a snapshot can express it: an
+  // EmotionsReset followed by the list would leave an empty or partial list if
+  // power failed between those records.
+  std::vector<const String *> replayOrder;
+  for (const auto &emotion : persisted_.emotions)
+  {
+    if (findByName(state.emotions, emotion.name) >= 0)
+    {
+      replayOrder.push_back(&emotion.name);
+    }
+  }
+  for (const auto &emotion : state.emotions)
+  {
+    if (findByName(persisted_.emotions, emotion.name) < 0)
+    {
+      replayOrder.push_back(&emotion.name);
+    }
+  }
+  bool orderPreserved = replayOrder.size() == state.emotions.size();
+  for (size_t index = 0; orderPreserved && index < replayOrder.size(); ++index)
+  {
+    orderPreserved = *replayOrder[index] == state.emotions[index].name;
+  }
+  if (!orderPreserved)
+  {
+    return false;
+  }
 
-  File file = LittleFS.open(kSettingsPath, FILE_WRITE);
-  if (!file)
+  auto appendRecord = [this, &records](RecordType type, const uint8_t *payload, size_t length)
+  {
+    if (records == 0 && !journal_.beginAppend())
+    {
+      return false;
+    }
+    if (!journal_.append(type, payload, length))
+    {
+      return false;
+    }
+    ++records;
+    return true;
+  };
+
+  if (state.brightness != persisted_.brightness &&
+      !appendRecord(RecordType::Brightness, &state.brightness, 1))
   {
-    Serial.println(F("[E] Could not open settings file for writing."));
     return false;
   }
 
-  if (serializeJson(document, file) == 0)
+  if (state.fanDutyCycle != persisted_.fanDutyCycle)
+  {
+    uint8_t payload[4];
+    writeInt32(payload, state.fanDutyCycle);
+    if (!appendRecord(RecordType::FanDutyCycle, payload, sizeof(payload)))
+    {
+      return false;
+    }
+  }
+
+  // Every record stands on its own, so a power cut part way through leaves a
+  // mix of old and new values but never drops an emotion: new and changed
+  // emotions go first and removals last, so a rename replays as old and new
+  // name side by side rather than neither.
+  for (const auto &emotion : state.emotions)
+  {
+    const int index = findByName(persisted_.emotions, emotion.name);
+    if (index >= 0 && persisted_.emotions[index].packed == emotion.packed)
+    {
+      continue;
+    }
+    if (!appendRecord(RecordType::EmotionUpsert, emotion.packed.data(), emotion.packed.size()))
+    {
+      return false;
+    }
+  }
+
+  for (const auto &emotion : persisted_.emotions)
+  {
+    if (findByName(state.emotions, emotion.name) < 0 &&
+        !appendRecord(RecordType::EmotionRemove, reinterpret_cast<const uint8_t *>(emotion.name.c_str()),
+                      emotion.name.length()))
+    {
+      return false;
+    }
+  }
+
+  if (state.currentEmotion != persisted_.currentEmotion &&
+      !appendRecord(RecordType::CurrentEmotion, reinterpret_cast<const uint8_t *>(state.currentEmotion.c_str()),
+                    state.currentEmotion.length()))
   {
-    Serial.println(F("[E] Failed to write settings JSON."));
-    file.close();
     return false;
   }
 
-  file.close();
-  Serial.println(F("[I] Settings saved."));
-  return true;
+  return records == 0 || journal_.commit();
+}
+
+bool SettingsStorage::writeSnapshot(const PersistedState &state)
+{
+  if (!journal_.beginSnapshot())
+  {
+    return false;
+  }
+
+  uint8_t fanPayload[4];
+  writeInt32(fanPayload, state.fanDutyCycle);
+
+  bool written = journal_.append(RecordType::Brightness, &state.brightness, 1) &&
+                 journal_.append(RecordType::FanDutyCycle, fanPayload, sizeof(fanPayload)) &&
+                 journal_.append(RecordType::EmotionsReset, nullptr, 0);
+  for (const auto &emotion : state.emotions)
+  {
+    written = written && journal_.append(RecordType::EmotionUpsert, emotion.packed.data(), emotion.packed.size());
+  }
+  written = written && journal_.append(RecordType::CurrentEmotion, state.currentEmotion) && journal_.commit();
+
+  if (!written)
+  {
+    journal_.abort();
+  }
+  return written;
 }
@@ -2,11 +2,17 @@
 #define SETTINGS_STORAGE_HPP
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 #include "LedBrightnessController.hpp"
 #include "EmotionState.hpp"
 #include "FanController.hpp"
 #include "EarController.hpp"
+#include "SettingsJournal.hpp"
 
 
 class SettingsStorage
@@ -16,15 +22,78 @@ public:
                   LedBrightnessController &brightnessController, EarController &earController);
 
   bool load();
-  bool save() const;
+  bool save();
+
+  // Same shape as the settings.json of earlier firmware.
+  void exportJson(JsonVariant json) const;
+  // Validates the whole document first; nothing is applied on error. The
+  // caller marks the settings dirty.
+  bool importJson(const JsonObject &object, String &error);
+
+  // Records a change; the write happens from update() once changes settle.
+  void markDirty();
+  // Call from the main loop. Writes kSaveDelayMs after the last change, or
+  // kMaxSaveLatencyMs after the first unsaved one while changes keep coming.
+  void update();
+  // Writes pending changes now (before OTA or a restart).
+  bool flush();
+  bool isDirty() const;
+
+  void serializeStats(JsonVariant json) const;
+
+  static constexpr uint32_t kSaveDelayMs = 2000;
+  static constexpr uint32_t kMaxSaveLatencyMs = 10000;
 
 private:
+  // Only read to migrate settings written by older firmware.
   static constexpr const char *kSettingsPath = "/settings.json";
+  static constexpr const char *kJournalPath = "/settings.log";
+
+  // What the journal currently holds, so a save appends only the differences.
+  struct PersistedEmotion
+  {
+    String name;
+    std::vector<uint8_t> packed;
+  };
+
+  struct PersistedState
+  {
+    bool valid = false;
+    uint8_t brightness = 0;
+    int fanDutyCycle = 0;
+    String currentEmotion;
+    std::vector<PersistedEmotion> emotions;
+  };
+
+  bool loadJournal();
+  bool loadJson();
+  PersistedState captureState() const;
+  bool appendChanges(const PersistedState &state, size_t &records);
+  bool writeSnapshot(const PersistedState &state);
+
+  // Call with saveMutex_ held.
+  bool saveLocked();
+
+  static void flushOnShutdown();
+  static SettingsStorage *instance_;
 
   EmotionState &emotionState_;
   FanController &fanController_;
   LedBrightnessController &brightnessController_;
   EarController &earController_;
+
+  SettingsJournal journal_;
+  PersistedState persisted_;
+  std::mutex saveMutex_;
+  std::atomic<bool> dirty_;
+  std::atomic<uint32_t> firstChangeMillis_;
+  std::atomic<uint32_t> lastChangeMillis_;
+  std::atomic<uint32_t> changeCount_;
+  uint32_t writeCount_;
+  uint32_t failedWriteCount_;
+  uint32_t lastWriteMillis_;
+  uint32_t lastWriteDurationMs_;
+  uint32_t maxWriteDurationMs_;
 };
 
 #endif // SETTINGS_STORAGE_HPP
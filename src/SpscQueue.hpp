@@ -0,0 +1,59 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <stddef.h>
+
+// Bounded lock-free queue between exactly one producer task and one consumer
+// task. Each side owns one counter; the release store that advances it
+// publishes the slot it just wrote or freed to the other side. The counters
+// run freely and wrap, which is why Capacity has to be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  SpscQueue() : head_(0), tail_(0) {}
+
+  // Producer only. Returns false when the queue is full.
+  bool push(const T &item)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Capacity)
+    {
+      return false;
+    }
+
+    items_[head & (Capacity - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Returns false when the queue is empty.
+  bool pop(T &item)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail)
+    {
+      return false;
+    }
+
+    item = items_[tail & (Capacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate from either side, exact from neither while the other runs.
+  size_t size() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+private:
+  T items_[Capacity];
+  std::atomic<size_t> head_;
+  std::atomic<size_t> tail_;
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,98 @@
+#include "StateStore.hpp"
+
+#include <string.h>
+
+StateStore::StateStore()
+    : staging_{},
+      sequence_(0)
+{
+  for (auto &word : words_)
+  {
+    word.store(0, std::memory_order_relaxed);
+  }
+}
+
+void StateStore::read(Snapshot &snapshot) const
+{
+  uint32_t words[kWordCount];
+  uint32_t sequence = 0;
+  while (true)
+  {
+    sequence = sequence_.load(std::memory_order_acquire);
+    if (sequence & 1U)
+    {
+      continue;
+    }
+
+    for (size_t index = 0; index < kWordCount; ++index)
+    {
+      words[index] = words_[index].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) == sequence)
+    {
+      break;
+    }
+  }
+
+  memcpy(&snapshot, words, sizeof(snapshot));
+  snapshot.version = sequence / 2;
+}
+
+uint32_t StateStore::getVersion() const
+{
+  return sequence_.load(std::memory_order_acquire) / 2;
+}
+
+void StateStore::publishEmotion(uint32_t revision, uint16_t id, const String &path, const String &name)
+{
+  if (path.length() > kMaxEmotionPathLength)
+  {
+    Serial.printf("[W] Emotion path too long to publish: %s\n", path.c_str());
+  }
+
+  std::lock_guard<std::mutex> lock(writeMutex_);
+  staging_.emotionRevision = revision;
+  staging_.emotionId = id;
+  strlcpy(staging_.emotionPath, path.c_str(), sizeof(staging_.emotionPath));
+  strlcpy(staging_.emotionName, name.c_str(), sizeof(staging_.emotionName));
+  publish();
+}
+
+void StateStore::publishBrightness(uint8_t brightness)
+{
+  std::lock_guard<std::mutex> lock(writeMutex_);
+  staging_.brightness = brightness;
+  publish();
+}
+
+void StateStore::publishFanDutyCycle(int dutyCycle)
+{
+  std::lock_guard<std::mutex> lock(writeMutex_);
+  staging_.fanDutyCycle = dutyCycle;
+  publish();
+}
+
+void StateStore::publishPower(float voltage, float currentMilliamps)
+{
+  std::lock_guard<std::mutex> lock(writeMutex_);
+  staging_.hasPower = 1;
+  staging_.voltage = voltage;
+  staging_.currentMilliamps = currentMilliamps;
+  publish();
+}
+
+void StateStore::publish()
+{
+  uint32_t words[kWordCount] = {};
+  memcpy(words, &staging_, sizeof(staging_));
+
+  const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t index = 0; index < kWordCount; ++index)
+  {
+    words_[index].store(words[index], std::memory_order_relaxed);
+  }
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,68 @@
+#ifndef STATE_STORE_HPP
+#define STATE_STORE_HPP
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <mutex>
+
+// Published copy of the state the render loop and remotes read: the current
+// emotion, LED brightness, fan duty cycle and the last system power sample.
+// The owning controllers are the only writers and publish through the
+// publish*() calls, which may come from any task (web, BLE, loop) and are
+// serialized by a mutex. Readers take a consistent snapshot with read()
+// without ever taking that mutex (seqlock): a read that overlaps a publish
+// simply copies again.
+//
+// Writers must not run below the priority of a reader on the same core, or
+// the reader could spin on a half-finished publish.
+class StateStore
+{
+public:
+  static constexpr size_t kMaxEmotionPathLength = 127;
+  // Longer display names are cut off; the OLED line is shorter anyway.
+  static constexpr size_t kMaxEmotionNameLength = 63;
+
+  struct Snapshot
+  {
+    // Increments with every publish.
+    uint32_t version;
+    uint32_t emotionRevision;
+    uint16_t emotionId;
+    uint8_t brightness;
+    int32_t fanDutyCycle;
+    // Set once the power sensor delivered a sample.
+    uint8_t hasPower;
+    float voltage;
+    float currentMilliamps;
+    char emotionPath[kMaxEmotionPathLength + 1];
+    // Definition name, or the file name for a plain path.
+    char emotionName[kMaxEmotionNameLength + 1];
+  };
+
+  StateStore();
+
+  void read(Snapshot &snapshot) const;
+  // Cheap check whether anything changed since a snapshot was taken.
+  uint32_t getVersion() const;
+
+  void publishEmotion(uint32_t revision, uint16_t id, const String &path, const String &name);
+  void publishBrightness(uint8_t brightness);
+  void publishFanDutyCycle(int dutyCycle);
+  void publishPower(float voltage, float currentMilliamps);
+
+private:
+  static constexpr size_t kWordCount = (sizeof(Snapshot) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  // Call with writeMutex_ held after changing staging_.
+  void publish();
+
+  std::mutex writeMutex_;
+  Snapshot staging_;
+  // Odd while a publish is in progress; the version is half of it.
+  std::atomic<uint32_t> sequence_;
+  // The published snapshot, word by word so concurrent reads are well defined.
+  std::atomic<uint32_t> words_[kWordCount];
+};
+
+#endif // STATE_STORE_HPP
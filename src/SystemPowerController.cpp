@@ -1,9 +1,21 @@
 #include "SystemPowerController.hpp"
 
-SystemPowerController::SystemPowerController(uint8_t sdaPin, uint8_t sclPin)
-    : sdaPin_(sdaPin),
+#include <math.h>
+
+namespace {
+constexpr float kVoltageThreshold = 0.05f;
+constexpr float kCurrentThresholdMilliamps = 20.0f;
+}
+
+SystemPowerController::SystemPowerController(StateStore &stateStore, uint8_t sdaPin, uint8_t sclPin)
+    : stateStore_(stateStore),
+      sdaPin_(sdaPin),
       sclPin_(sclPin),
-      enabled_(false) {}
+      enabled_(false),
+      hasSample_(false),
+      voltage_(0.0f),
+      currentMilliamps_(0.0f),
+      lastSampleMillis_(0) {}
 
 bool SystemPowerController::begin() {
   Wire.begin(sdaPin_, sclPin_);
@@ -15,19 +27,65 @@ bool SystemPowerController::begin() {
   return enabled_;
 }
 
+void SystemPowerController::update() {
+  const unsigned long now = millis();
+  if (!enabled_ || (hasSample_ && now - lastSampleMillis_ < kSampleIntervalMs)) {
+    return;
+  }
+  lastSampleMillis_ = now;
+
+  float voltage = 0.0f;
+  float currentMilliamps = 0.0f;
+  if (!readPower(voltage, currentMilliamps)) {
+    return;
+  }
+
+  // Sensor noise alone is not published, so readers only see real changes.
+  if (hasSample_ && fabsf(voltage - voltage_) < kVoltageThreshold &&
+      fabsf(currentMilliamps - currentMilliamps_) < kCurrentThresholdMilliamps) {
+    return;
+  }
+  hasSample_ = true;
+  voltage_ = voltage;
+  currentMilliamps_ = currentMilliamps;
+  stateStore_.publishPower(voltage, currentMilliamps);
+}
+
 bool SystemPowerController::isEnabled() const {
   return enabled_;
 }
 
-String SystemPowerController::readPowerInfo() {
+String SystemPowerController::readPowerInfo() const {
+  char buffer[40];
+  formatPowerInfo(buffer, sizeof(buffer));
+  return String(buffer);
+}
+
+size_t SystemPowerController::formatPowerInfo(char *buffer, size_t size) const {
   if (!enabled_) {
-    return F("System power sensor is disabled");
+    return strlcpy(buffer, "System power sensor is disabled", size);
+  }
+
+  // Safe from any task; the sensor itself is only read by update().
+  StateStore::Snapshot snapshot;
+  stateStore_.read(snapshot);
+  if (!snapshot.hasPower) {
+    return strlcpy(buffer, "System power read error", size);
+  }
+
+  const int written = snprintf(buffer, size, "%.2fV  %.0fmA", snapshot.voltage, snapshot.currentMilliamps);
+  return written > 0 ? static_cast<size_t>(written) : 0;
+}
+
+bool SystemPowerController::readPower(float &voltage, float &currentMilliamps) {
+  if (!enabled_) {
+    return false;
   }
 
   uint16_t rawBusVoltage = 0;
   uint16_t rawShuntVoltage = 0;
   if (!readRegister16(kBusVoltageRegister, rawBusVoltage) || !readRegister16(kShuntVoltageRegister, rawShuntVoltage)) {
-    return F("System power read error");
+    return false;
   }
   
   // INA219:
@@ -35,15 +93,14 @@ String SystemPowerController::readPowerInfo() {
   // Shunt voltage register: signed 16-bit, LSB = 10 uV
   // Shunt resistor: 0.02 ohm
 
-  const float voltage = static_cast<float>(rawBusVoltage >> 3) * 0.004f;
+  voltage = static_cast<float>(rawBusVoltage >> 3) * 0.004f;
 
   const int16_t signedShuntVoltage = static_cast<int16_t>(rawShuntVoltage);
   const float shuntVolts = static_cast<float>(signedShuntVoltage) * 0.00001f;
 
   const float currentAmps = shuntVolts / kShuntResistorOhms;
-  const float currentMilliamps = currentAmps * 1000.0f;
-
-  return String(voltage, 2) + F("V  ") + String(currentMilliamps, 0) + F("mA");
+  currentMilliamps = currentAmps * 1000.0f;
+  return true;
 }
 
 bool SystemPowerController::readRegister16(uint8_t reg, uint16_t &value) const {
@@ -4,20 +4,37 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#include "StateStore.hpp"
+
+// The only reader of the power sensor. update() samples it from the loop and
+// publishes changes beyond sensor noise to the state store, where the OLED,
+// the web server and BLE all read it.
 class SystemPowerController {
 public:
-  explicit SystemPowerController(uint8_t sdaPin, uint8_t sclPin);
+  SystemPowerController(StateStore &stateStore, uint8_t sdaPin, uint8_t sclPin);
 
   bool begin();
+  // Call from loop(); samples every kSampleIntervalMs.
+  void update();
   bool isEnabled() const;
-  String readPowerInfo();
+  // Formats the last published sample.
+  String readPowerInfo() const;
+  size_t formatPowerInfo(char *buffer, size_t size) const;
+
+  static constexpr unsigned long kSampleIntervalMs = 2000;
 
 private:
+  bool readPower(float &voltage, float &currentMilliamps);
   bool readRegister16(uint8_t reg, uint16_t &value) const;
 
+  StateStore &stateStore_;
   uint8_t sdaPin_;
   uint8_t sclPin_;
   bool enabled_;
+  bool hasSample_;
+  float voltage_;
+  float currentMilliamps_;
+  unsigned long lastSampleMillis_;
 
   static constexpr uint8_t kIna226Address = 0x40;
   static constexpr uint8_t kBusVoltageRegister = 0x02;
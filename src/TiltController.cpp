@@ -1,13 +1,16 @@
 #include "TiltController.hpp"
 
+#include "HeapMonitor.hpp"
+
 TiltController::TiltController(EmotionState &emotionState, uint8_t sdaPin, uint8_t sclPin)
     : sdaPin_(sdaPin),
       sclPin_(sclPin),
       emotionState_(emotionState),
-      tiltEnabled_(true),
+      tiltEnabled_(false),
       lastUpdateMillis_(0),
       tiltChangeMillis_(0),
-      wasTilt_(false) {}
+      wasTilt_(false),
+      position_(Position::Neutral) {}
 
 bool TiltController::begin() {
   Wire.begin(sdaPin_, sclPin_);
@@ -24,6 +27,8 @@ bool TiltController::begin() {
 }
 
 void TiltController::update() {
+  HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Tilt);
+
   if (!tiltEnabled_) {
     return;
   }
@@ -38,17 +43,20 @@ void TiltController::update() {
                                  tiltUpX_, tiltUpY_, tiltUpZ_, tiltTolerance_) && !wasTilt_) {
     Serial.println(F("[I] Tilt: UP!"));
     wasTilt_ = true;
-    handleTiltChange(emotionState_.getTiltUpEmotion());
+    position_ = Position::Up;
+    handleTiltChange();
   } else if (floatHelper_.isApproxEqual(mpu6050_->getAccX(), mpu6050_->getAccY(), mpu6050_->getAccZ(),
                                         tiltSideX_, tiltSideY_, tiltSideZ_, tiltTolerance_) && !wasTilt_) {
     Serial.println(F("[I] Tilt: Side!"));
     wasTilt_ = true;
-    handleTiltChange(emotionState_.getTiltSideEmotion());
+    position_ = Position::Side;
+    handleTiltChange();
   } else if ((wasTilt_ && (millis() - tiltChangeMillis_ > tiltAnimationMaxDuration_)) ||
              (wasTilt_ && floatHelper_.isApproxEqual(mpu6050_->getAccX(), mpu6050_->getAccY(), mpu6050_->getAccZ(),
                                                      tiltNeutralX_, tiltNeutralY_, tiltNeutralZ_, tiltTolerance_))) {
     Serial.println(F("[I] Tilt: Neutral!"));
     wasTilt_ = false;
+    position_ = Position::Neutral;
   }
 
   lastUpdateMillis_ = millis();
@@ -58,6 +66,21 @@ bool TiltController::isEnabled() const {
   return tiltEnabled_;
 }
 
+TiltController::Position TiltController::getPosition() const {
+  return position_;
+}
+
+const char *TiltController::getPositionName(Position position) {
+  switch (position) {
+    case Position::Up:
+      return "up";
+    case Position::Side:
+      return "side";
+    default:
+      return "neutral";
+  }
+}
+
 String TiltController::readAcceleration() {
   if (!tiltEnabled_) {
     return F("Tilt is disabled");
@@ -66,7 +89,12 @@ String TiltController::readAcceleration() {
   return String(mpu6050_->getAccX(), 2) + ";" + String(mpu6050_->getAccY(), 2) + ";" + String(mpu6050_->getAccZ(), 2);
 }
 
-void TiltController::handleTiltChange(const String &targetEmotion) {
-  emotionState_.setCurrentEmotion(targetEmotion);
+void TiltController::handleTiltChange() {
+  // The tilt emotions are read under the state's own lock, only on a change.
+  if (position_ == Position::Up) {
+    emotionState_.showTiltUpEmotion();
+  } else {
+    emotionState_.showTiltSideEmotion();
+  }
   tiltChangeMillis_ = millis();
 }
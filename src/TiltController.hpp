@@ -11,16 +11,20 @@
 
 class TiltController {
 public:
+  enum class Position { Neutral, Up, Side };
+
   explicit TiltController(EmotionState &emotionState, uint8_t sdaPin, uint8_t sclPin);
 
   bool begin();
   void update();
 
   bool isEnabled() const;
+  Position getPosition() const;
+  static const char *getPositionName(Position position);
   String readAcceleration();
 
 private:
-  void handleTiltChange(const String &targetEmotion);
+  void handleTiltChange();
 
   EmotionState &emotionState_;
   uint8_t sdaPin_;
@@ -30,6 +34,7 @@ private:
   unsigned long lastUpdateMillis_;
   unsigned long tiltChangeMillis_;
   bool wasTilt_;
+  Position position_;
   FloatHelper floatHelper_;
 
   const float tiltNeutralX_ = 0.3f;
@@ -0,0 +1,91 @@
+#include "JsonArrayStream.hpp"
+
+#include <memory>
+
+namespace
+{
+struct StreamState
+{
+  JsonArrayStream::ElementProducer producer;
+  char pending[JsonArrayStream::kMaxElementBytes + 1];
+  size_t pendingLength = 0;
+  size_t pendingOffset = 0;
+  size_t elementCount = 0;
+  bool started = false;
+  bool finished = false;
+
+  void setPending(const char *text)
+  {
+    pendingLength = strlcpy(pending, text, sizeof(pending));
+    pendingOffset = 0;
+  }
+
+  void fillNext()
+  {
+    if (!started)
+    {
+      started = true;
+      setPending("[");
+      return;
+    }
+
+    JsonDocument element;
+    while (producer(element))
+    {
+      const size_t prefixLength = elementCount > 0 ? 1 : 0;
+      if (measureJson(element) + prefixLength > JsonArrayStream::kMaxElementBytes)
+      {
+        Serial.println(F("[W] Skipping JSON element larger than the stream buffer"));
+        element.clear();
+        continue;
+      }
+
+      pending[0] = ',';
+      pendingLength = prefixLength + serializeJson(element, pending + prefixLength,
+                                                   sizeof(pending) - prefixLength);
+      pendingOffset = 0;
+      ++elementCount;
+      return;
+    }
+
+    finished = true;
+    setPending("]");
+  }
+};
+} // namespace
+
+AsyncWebServerResponse *JsonArrayStream::beginResponse(AsyncWebServerRequest *request, ElementProducer producer)
+{
+  auto state = std::make_shared<StreamState>();
+  state->producer = std::move(producer);
+
+  return request->beginChunkedResponse(
+      "application/json",
+      [state](uint8_t *buffer, size_t maxLen, size_t /*index*/) -> size_t
+      {
+        size_t written = 0;
+        while (written < maxLen)
+        {
+          if (state->pendingOffset < state->pendingLength)
+          {
+            size_t toCopy = state->pendingLength - state->pendingOffset;
+            if (toCopy > maxLen - written)
+            {
+              toCopy = maxLen - written;
+            }
+            memcpy(buffer + written, state->pending + state->pendingOffset, toCopy);
+            state->pendingOffset += toCopy;
+            written += toCopy;
+            continue;
+          }
+
+          if (state->finished)
+          {
+            break;
+          }
+
+          state->fillNext();
+        }
+        return written;
+      });
+}
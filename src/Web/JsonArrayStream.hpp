@@ -0,0 +1,22 @@
+#ifndef JSONARRAYSTREAM_HPP
+#define JSONARRAYSTREAM_HPP
+
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+
+#include <functional>
+
+// Sends a JSON array as a chunked response, serializing one element per step so the
+// peak heap use does not depend on the number of elements.
+class JsonArrayStream
+{
+public:
+    // Fills `element` with the next item, returns false once the array is complete.
+    using ElementProducer = std::function<bool(JsonDocument &element)>;
+
+    static constexpr size_t kMaxElementBytes = 512;
+
+    static AsyncWebServerResponse *beginResponse(AsyncWebServerRequest *request, ElementProducer producer);
+};
+
+#endif // JSONARRAYSTREAM_HPP
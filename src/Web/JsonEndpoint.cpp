@@ -1,6 +1,9 @@
 #include "JsonEndpoint.hpp"
 
-void JsonEndpoint::addJsonHandler(AsyncWebServer &server, WebRequestMethodComposite method, const char *uri, JsonRouteHandler handler)
+#include "HeapMonitor.hpp"
+
+void JsonEndpoint::addJsonHandler(AsyncWebServer &server, WebRequestMethodComposite method, const char *uri, JsonRouteHandler handler,
+                                  size_t maxBodyBytes)
 {
   server.on(
       uri,
@@ -10,8 +13,10 @@ void JsonEndpoint::addJsonHandler(AsyncWebServer &server, WebRequestMethodCompos
         // Response is sent in body callback
       },
       nullptr,
-      [handler](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+      [handler, maxBodyBytes](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
       {
+        HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Web);
+
         // First chunk: validate content type and allocate buffer
         if (index == 0)
         {
@@ -28,43 +33,46 @@ void JsonEndpoint::addJsonHandler(AsyncWebServer &server, WebRequestMethodCompos
             return;
           }
 
-          JsonBodyContext *ctx = new JsonBodyContext();
-          ctx->body.reserve(total);
-          request->_tempObject = ctx;
+          if (total > maxBodyBytes)
+          {
+            request->send(413, "text/plain", "error: JSON body too large");
+            return;
+          }
+
+          // Plain malloc buffer: the web server free()s _tempObject itself if the client disconnects.
+          request->_tempObject = malloc(total);
+          if (!request->_tempObject)
+          {
+            request->send(503, "text/plain", "error: Out of memory");
+            return;
+          }
         }
 
-        if (!request->_tempObject)
+        if (!request->_tempObject || index + len > total)
         {
           return;
         }
 
-        JsonBodyContext *ctx = reinterpret_cast<JsonBodyContext *>(request->_tempObject);
-
-        for (size_t i = 0; i < len; i++)
-        {
-          ctx->body += static_cast<char>(data[i]);
-        }
+        uint8_t *body = static_cast<uint8_t *>(request->_tempObject);
+        memcpy(body + index, data, len);
 
         // Last chunk: deserialize and dispatch
         if (index + len == total)
         {
           JsonDocument doc;
-          DeserializationError err = deserializeJson(doc, ctx->body);
+          DeserializationError err = deserializeJson(doc, static_cast<const uint8_t *>(body), total);
+
+          free(body);
+          request->_tempObject = nullptr;
 
           if (err)
           {
-            delete ctx;
-            request->_tempObject = nullptr;
-
             request->send(400, "text/plain", "error: Invalid JSON");
             return;
           }
 
           auto response = handler(request, doc);
 
-          delete ctx;
-          request->_tempObject = nullptr;
-
           request->send(response.statusCode, response.contentType, response.body);
         }
       });
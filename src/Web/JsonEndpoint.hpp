@@ -4,11 +4,6 @@
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
 
-struct JsonBodyContext
-{
-  String body;
-};
-
 struct Response
 {
     String body;
@@ -24,8 +19,14 @@ using JsonRouteHandler = std::function<Response(
 
 class JsonEndpoint
 {
+public:
+    // Bodies above this size are rejected with 413 before any of them is buffered.
+    static constexpr size_t kMaxJsonBodyBytes = 8 * 1024;
+
 protected:
-    void addJsonHandler(AsyncWebServer &server, WebRequestMethodComposite method, const char *uri, JsonRouteHandler handler);
+    // Routes taking whole documents (e.g. a settings import) pass a larger maxBodyBytes.
+    void addJsonHandler(AsyncWebServer &server, WebRequestMethodComposite method, const char *uri, JsonRouteHandler handler,
+                        size_t maxBodyBytes = kMaxJsonBodyBytes);
 };
 
 #endif // JSONENDPOINT_HPP
\ No newline at end of file
@@ -0,0 +1,361 @@
+#include "WebEndpoints/Batch/BatchEndpoint.hpp"
+
+#include <ArduinoJson.h>
+
+namespace
+{
+String buildError(size_t index, const String &message)
+{
+  JsonDocument document;
+  document["index"] = index;
+  document["error"] = message;
+
+  String json;
+  serializeJson(document, json);
+  return json;
+}
+
+// Name and path of an emotion as it will be once the earlier operations ran.
+struct PlannedEmotion
+{
+  String name;
+  String path;
+};
+
+// Same lookup as EmotionState::upsertEmotionDefinition: by name, then by path.
+int findPlanned(const std::vector<PlannedEmotion> &planned, const String &name, const String *path)
+{
+  for (size_t i = 0; i < planned.size(); i++)
+  {
+    if (planned[i].name == name)
+    {
+      return static_cast<int>(i);
+    }
+  }
+  for (size_t i = 0; path != nullptr && i < planned.size(); i++)
+  {
+    if (planned[i].path == *path)
+    {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+} // namespace
+
+BatchEndpoint::BatchEndpoint(EmotionState &emotionState, EarController &earController,
+                             LedBrightnessController &brightnessController,
+                             FanController &fanController,
+                             std::function<void()> onSettingsChanged)
+    : emotionState_(emotionState),
+      earController_(earController),
+      brightnessController_(brightnessController),
+      fanController_(fanController),
+      onSettingsChanged_(onSettingsChanged)
+{
+}
+
+void BatchEndpoint::registerEndpoint(AsyncWebServer &server)
+{
+  addJsonHandler(
+      server,
+      HTTP_POST,
+      "/batch",
+      [this](AsyncWebServerRequest *request, JsonDocument &doc)
+      {
+        return handlePost(request, doc);
+      });
+}
+
+Response BatchEndpoint::handlePost(AsyncWebServerRequest *request, JsonDocument &doc)
+{
+  JsonArray operationsJson = doc.is<JsonArray>() ? doc.as<JsonArray>() : doc["operations"].as<JsonArray>();
+  if (operationsJson.isNull() || operationsJson.size() == 0)
+  {
+    return {F("JSON array 'operations' is required."), "text/plain", 400};
+  }
+
+  if (operationsJson.size() > kMaxOperations)
+  {
+    return {F("Too many operations in one batch."), "text/plain", 413};
+  }
+
+  // Validation and the changes run as one step against the same emotion state.
+  const auto emotionLock = emotionState_.lock();
+  std::vector<Operation> operations;
+  operations.reserve(operationsJson.size());
+  for (JsonObject object : operationsJson)
+  {
+    Operation operation;
+    String error;
+    if (!parseOperation(object, operation, error))
+    {
+      return {buildError(operations.size(), error), "application/json", 400};
+    }
+    operations.push_back(operation);
+  }
+
+  size_t failedIndex = 0;
+  String error;
+  if (!validateEmotionChanges(operations, failedIndex, error))
+  {
+    return {buildError(failedIndex, error), "application/json", 409};
+  }
+
+  JsonDocument result;
+  JsonArray results = result["results"].to<JsonArray>();
+  size_t applied = 0;
+  String message;
+  bool failed = false;
+  for (; applied < operations.size(); applied++)
+  {
+    if (!applyOperation(operations[applied], message))
+    {
+      // Validation mirrors the state, so this is not expected; the
+      // operations before it stay applied and are reported as such.
+      failed = true;
+      break;
+    }
+    results.add(message);
+  }
+  result["applied"] = applied;
+  if (failed)
+  {
+    result["index"] = applied;
+    result["error"] = message;
+  }
+
+  if (applied > 0 && onSettingsChanged_)
+  {
+    onSettingsChanged_();
+  }
+
+  String json;
+  serializeJson(result, json);
+  return {json, "application/json", failed ? 409 : 200};
+}
+
+bool BatchEndpoint::parseOperation(JsonObject object, Operation &operation, String &error) const
+{
+  if (object.isNull() || !object["op"].is<const char *>())
+  {
+    error = F("Every operation needs an 'op' string.");
+    return false;
+  }
+
+  const String op = object["op"].as<String>();
+  if (op == "emotion" || op == "deleteEmotion")
+  {
+    operation.type = op == "emotion" ? OperationType::SetEmotion : OperationType::DeleteEmotion;
+    if (object["id"].is<int>())
+    {
+      const int id = object["id"].as<int>();
+      const EmotionDefinition *emotion =
+          id > 0 && id <= UINT16_MAX ? emotionState_.getEmotionDefinitionById(static_cast<uint16_t>(id)) : nullptr;
+      if (emotion == nullptr)
+      {
+        error = F("Unknown emotion 'id'.");
+        return false;
+      }
+      operation.name = emotion->name;
+      return true;
+    }
+    if (!object["name"].is<const char *>() || object["name"].as<String>().isEmpty())
+    {
+      error = F("'name' or 'id' is required.");
+      return false;
+    }
+    operation.name = object["name"].as<String>();
+    return true;
+  }
+
+  if (op == "createEmotion" || op == "updateEmotion")
+  {
+    if (!object["emotion"].is<JsonObject>())
+    {
+      error = F("'emotion' object is required.");
+      return false;
+    }
+    operation.type = op == "createEmotion" ? OperationType::CreateEmotion : OperationType::UpdateEmotion;
+    return operation.emotion.deserialize(object["emotion"].as<JsonObject>(), error);
+  }
+
+  if (op == "brightness")
+  {
+    operation.type = OperationType::SetBrightness;
+    if (object["brightnessPercent"].is<float>())
+    {
+      const float percent = object["brightnessPercent"].as<float>();
+      if (percent > 100.0f || percent < 0.0f)
+      {
+        error = F("Could not set brightness use 0-100 percent.");
+        return false;
+      }
+      operation.percent = percent;
+      return true;
+    }
+    if (object["brightness"].is<int>())
+    {
+      operation.value = object["brightness"].as<int>();
+      if (operation.value >= 256 || operation.value < 0)
+      {
+        error = F("Could not set brightness use 0-255 value.");
+        return false;
+      }
+      return true;
+    }
+    error = F("'brightness' or 'brightnessPercent' is required.");
+    return false;
+  }
+
+  if (op == "fan")
+  {
+    operation.type = OperationType::SetFan;
+    if (object["dutyPercent"].is<float>())
+    {
+      const float percent = object["dutyPercent"].as<float>();
+      if (percent > 100.0f || percent < 0.0f)
+      {
+        error = F("Invalid duty cycle percent.");
+        return false;
+      }
+      operation.percent = percent;
+      return true;
+    }
+    if (object["duty"].is<int>())
+    {
+      operation.value = object["duty"].as<int>();
+      if (operation.value < 0 || operation.value > fanController_.getMaxDutyCycle())
+      {
+        error = F("Invalid duty cycle");
+        return false;
+      }
+      return true;
+    }
+    error = F("'duty' or 'dutyPercent' is required.");
+    return false;
+  }
+
+  error = String(F("Unknown operation '")) + op + "'.";
+  return false;
+}
+
+bool BatchEndpoint::validateEmotionChanges(const std::vector<Operation> &operations, size_t &failedIndex, String &error) const
+{
+  // Emotions created, changed or deleted earlier in the same batch count with
+  // their new names and paths, so the checks match what applying will do.
+  std::vector<PlannedEmotion> planned;
+  for (const auto &emotion : emotionState_.getEmotionDefinitions())
+  {
+    planned.push_back({emotion.name, emotion.path});
+  }
+
+  for (size_t i = 0; i < operations.size(); i++)
+  {
+    const Operation &operation = operations[i];
+    failedIndex = i;
+
+    switch (operation.type)
+    {
+    case OperationType::CreateEmotion:
+      if (findPlanned(planned, operation.emotion.name, &operation.emotion.path) >= 0)
+      {
+        error = F("Emotion already exists.");
+        return false;
+      }
+      planned.push_back({operation.emotion.name, operation.emotion.path});
+      break;
+    case OperationType::UpdateEmotion:
+    {
+      const int index = findPlanned(planned, operation.emotion.name, &operation.emotion.path);
+      if (index < 0)
+      {
+        error = F("Emotion does not exist.");
+        return false;
+      }
+      planned[index] = {operation.emotion.name, operation.emotion.path};
+      break;
+    }
+    case OperationType::DeleteEmotion:
+    {
+      const int index = findPlanned(planned, operation.name, nullptr);
+      if (index < 0)
+      {
+        error = F("Emotion not found.");
+        return false;
+      }
+      planned.erase(planned.begin() + index);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+bool BatchEndpoint::applyOperation(const Operation &operation, String &message)
+{
+  switch (operation.type)
+  {
+  case OperationType::SetEmotion:
+    emotionState_.setCurrentEmotion(operation.name);
+    earController_.applyEmotionEarColor(emotionState_.getCurrentEmotionDefinition());
+    message = F("Emotion changed.");
+    return true;
+
+  case OperationType::CreateEmotion:
+    if (!emotionState_.upsertEmotionDefinition(operation.emotion, false))
+    {
+      message = F("Emotion already exists.");
+      return false;
+    }
+    message = F("Emotion created.");
+    return true;
+
+  case OperationType::UpdateEmotion:
+    if (!emotionState_.upsertEmotionDefinition(operation.emotion, true))
+    {
+      message = F("Emotion could not be updated.");
+      return false;
+    }
+    earController_.applyEmotionEarColor(emotionState_.getCurrentEmotionDefinition());
+    message = F("Emotion updated.");
+    return true;
+
+  case OperationType::DeleteEmotion:
+    if (!emotionState_.removeEmotionDefinitionByName(operation.name))
+    {
+      message = F("Emotion not found.");
+      return false;
+    }
+    message = F("Emotion removed.");
+    return true;
+
+  case OperationType::SetBrightness:
+    if (operation.percent >= 0.0f)
+    {
+      brightnessController_.setBrightnessPercent(operation.percent);
+    }
+    else
+    {
+      brightnessController_.setBrightness(static_cast<uint8_t>(operation.value));
+    }
+    message = F("Brightness set.");
+    return true;
+
+  case OperationType::SetFan:
+    if (operation.percent >= 0.0f)
+    {
+      fanController_.setDutyCyclePercent(operation.percent);
+    }
+    else
+    {
+      fanController_.setDutyCycle(operation.value);
+    }
+    message = "Set PWM to: " + String(fanController_.getDutyCycle());
+    return true;
+  }
+
+  return false;
+}
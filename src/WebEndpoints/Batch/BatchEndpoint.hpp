@@ -0,0 +1,61 @@
+#ifndef WEB_ENDPOINTS_BATCH_BATCH_ENDPOINT_HPP
+#define WEB_ENDPOINTS_BATCH_BATCH_ENDPOINT_HPP
+
+#include <ESPAsyncWebServer.h>
+#include <functional>
+#include <vector>
+
+#include "Web/JsonEndpoint.hpp"
+#include "EarController.hpp"
+#include "EmotionState.hpp"
+#include "FanController.hpp"
+#include "LedBrightnessController.hpp"
+
+// Applies several state changes from one request. Every operation is validated
+// before any is applied, and settings are saved once at the end.
+class BatchEndpoint : public JsonEndpoint
+{
+public:
+  static constexpr size_t kMaxOperations = 16;
+
+  BatchEndpoint(EmotionState &emotionState, EarController &earController,
+                LedBrightnessController &brightnessController, FanController &fanController,
+                std::function<void()> onSettingsChanged);
+
+  void registerEndpoint(AsyncWebServer &server);
+
+private:
+  enum class OperationType
+  {
+    SetEmotion,
+    CreateEmotion,
+    UpdateEmotion,
+    DeleteEmotion,
+    SetBrightness,
+    SetFan
+  };
+
+  struct Operation
+  {
+    OperationType type = OperationType::SetEmotion;
+    String name;
+    EmotionDefinition emotion;
+    int value = 0;
+    // Set when the value was given in percent.
+    float percent = -1.0f;
+  };
+
+  Response handlePost(AsyncWebServerRequest *request, JsonDocument &doc);
+  bool parseOperation(JsonObject object, Operation &operation, String &error) const;
+  bool validateEmotionChanges(const std::vector<Operation> &operations, size_t &failedIndex, String &error) const;
+  // False when the state rejected the change; `message` then says why.
+  bool applyOperation(const Operation &operation, String &message);
+
+  EmotionState &emotionState_;
+  EarController &earController_;
+  LedBrightnessController &brightnessController_;
+  FanController &fanController_;
+  std::function<void()> onSettingsChanged_;
+};
+
+#endif // WEB_ENDPOINTS_BATCH_BATCH_ENDPOINT_HPP
@@ -2,6 +2,20 @@
 
 #include <ArduinoJson.h>
 
+namespace
+{
+bool parseEmotionId(const String &value, uint16_t &id)
+{
+  const long parsed = value.toInt();
+  if (parsed <= 0 || parsed > UINT16_MAX)
+  {
+    return false;
+  }
+  id = static_cast<uint16_t>(parsed);
+  return true;
+}
+} // namespace
+
 EmotionEndpoint::EmotionEndpoint(EmotionState &emotionState,
                                  EarController &earController,
                                  std::function<void()> onSettingsChanged)
@@ -35,7 +49,13 @@ void EmotionEndpoint::registerEndpoint(AsyncWebServer &server)
 
 void EmotionEndpoint::handleGet(AsyncWebServerRequest *request)
 {
+  const auto emotionLock = emotionState_.lock();
   const auto *emotion = emotionState_.getCurrentEmotionDefinition();
+  if (emotion == nullptr)
+  {
+    request->send(404, "text/plain", F("Current emotion has no definition."));
+    return;
+  }
   sendEmotionJson(request, *emotion);
 }
 
@@ -81,6 +101,7 @@ Response EmotionEndpoint::handlePut(AsyncWebServerRequest *request, JsonDocument
     return { error, "text/plain", 400};
   }
 
+  const auto emotionLock = emotionState_.lock();
   if (emotionState_.getEmotionDefinitionByName(emotion.name) == nullptr &&
       emotionState_.getEmotionDefinitionByPath(emotion.path) == nullptr)
   {
@@ -105,14 +126,23 @@ Response EmotionEndpoint::handlePut(AsyncWebServerRequest *request, JsonDocument
 
 void EmotionEndpoint::handleDelete(AsyncWebServerRequest *request)
 {
-  if (!request->hasParam("name"))
+  bool removed = false;
+  if (request->hasParam("id"))
+  {
+    uint16_t id = 0;
+    removed = parseEmotionId(request->getParam("id")->value(), id) && emotionState_.removeEmotionDefinitionById(id);
+  }
+  else if (request->hasParam("name"))
+  {
+    removed = emotionState_.removeEmotionDefinitionByName(request->getParam("name")->value());
+  }
+  else
   {
-    request->send(400, "text/plain", F("Parameter 'name' is required."));
+    request->send(400, "text/plain", F("Parameter 'name' or 'id' is required."));
     return;
   }
 
-  const String name = request->getParam("name")->value();
-  if (!emotionState_.removeEmotionDefinitionByName(name))
+  if (!removed)
   {
     request->send(404, "text/plain", F("Emotion not found."));
     return;
@@ -123,7 +153,25 @@ void EmotionEndpoint::handleDelete(AsyncWebServerRequest *request)
 
 void EmotionEndpoint::handleSetCurrentEmotion(AsyncWebServerRequest *request)
 {
-  emotionState_.setCurrentEmotion(request->getParam("name", true)->value());
+  const auto emotionLock = emotionState_.lock();
+  if (request->hasParam("id", true))
+  {
+    uint16_t id = 0;
+    if (!parseEmotionId(request->getParam("id", true)->value(), id) || !emotionState_.setCurrentEmotionById(id))
+    {
+      request->send(404, "text/plain", F("Emotion not found."));
+      return;
+    }
+  }
+  else if (request->hasParam("name", true))
+  {
+    emotionState_.setCurrentEmotion(request->getParam("name", true)->value());
+  }
+  else
+  {
+    request->send(400, "text/plain", F("Parameter 'name' or 'id' is required."));
+    return;
+  }
   earController_.applyEmotionEarColor(emotionState_.getCurrentEmotionDefinition());
   if (onSettingsChanged_)
   {
@@ -2,6 +2,8 @@
 
 #include <ArduinoJson.h>
 
+#include "Web/JsonArrayStream.hpp"
+
 EmotionsEndpoint::EmotionsEndpoint(EmotionState &emotionState)
     : emotionState_(emotionState)
 {
@@ -15,15 +17,19 @@ void EmotionsEndpoint::registerEndpoint(AsyncWebServer &server)
 
 void EmotionsEndpoint::handleGet(AsyncWebServerRequest *request)
 {
-  JsonDocument document;
-  JsonArray emotions = document.to<JsonArray>();
-  for (const auto &emotion : emotionState_.getEmotionDefinitions())
-  {
-    JsonObject emotionObject = emotions.add<JsonObject>();
-    emotion.serialize(emotionObject);
-  }
-
-  String json;
-  serializeJson(document, json);
-  request->send(200, "application/json", json);
+  size_t nextIndex = 0;
+  request->send(JsonArrayStream::beginResponse(
+      request,
+      [this, nextIndex](JsonDocument &element) mutable
+      {
+        // Locked per element: the list may change between chunks, the index stays in bounds.
+        const auto emotionLock = emotionState_.lock();
+        const auto &emotions = emotionState_.getEmotionDefinitions();
+        if (nextIndex >= emotions.size())
+        {
+          return false;
+        }
+        emotions[nextIndex++].serialize(element.to<JsonObject>());
+        return true;
+      }));
 }
@@ -1,5 +1,6 @@
 #include "WebEndpoints/Files/FileEndpoint.hpp"
 
+#include <ArduinoJson.h>
 #include <LittleFS.h>
 
 #include <FS.h>
@@ -7,9 +8,63 @@
 
 namespace
 {
-constexpr size_t kDownloadChunkSizeBytes = 1024;
-constexpr size_t kMaxDownloadBytes = 512 * 1024;
 constexpr uint32_t kMinDownloadFreeHeapBytes = 20 * 1024;
+constexpr const char *kAssetPathPrefix = "/anims/";
+
+String buildETag(size_t size, time_t modified)
+{
+  char etag[32];
+  snprintf(etag, sizeof(etag), "\"%lx-%lx\"", static_cast<unsigned long>(size),
+           static_cast<unsigned long>(modified));
+  return String(etag);
+}
+
+// Parses a single "bytes=first-last", "bytes=first-" or "bytes=-suffix" range.
+// Returns false when the header is not something we serve as a range (the full file is sent instead).
+bool parseRange(const String &header, size_t fileSize, size_t &first, size_t &last, bool &satisfiable)
+{
+  satisfiable = true;
+  if (!header.startsWith("bytes=") || header.indexOf(',') >= 0)
+  {
+    return false;
+  }
+
+  const int dash = header.indexOf('-');
+  if (dash < 0)
+  {
+    return false;
+  }
+
+  const String firstText = header.substring(6, dash);
+  const String lastText = header.substring(dash + 1);
+
+  if (firstText.isEmpty())
+  {
+    const long suffixLength = lastText.toInt();
+    if (suffixLength <= 0 || fileSize == 0)
+    {
+      satisfiable = false;
+      return true;
+    }
+    first = static_cast<size_t>(suffixLength) >= fileSize ? 0 : fileSize - static_cast<size_t>(suffixLength);
+    last = fileSize - 1;
+    return true;
+  }
+
+  first = static_cast<size_t>(firstText.toInt());
+  last = lastText.isEmpty() ? fileSize - 1 : static_cast<size_t>(lastText.toInt());
+  if (first >= fileSize || last < first)
+  {
+    satisfiable = false;
+    return true;
+  }
+
+  if (last >= fileSize)
+  {
+    last = fileSize - 1;
+  }
+  return true;
+}
 }
 
 FileEndpoint::FileEndpoint(FileManager &fileManager, bool allowAllFileChanges)
@@ -48,6 +103,11 @@ void FileEndpoint::registerEndpoint(AsyncWebServer &server)
 
   server.on("/file", HTTP_DELETE, [this](AsyncWebServerRequest *request)
             { handleDelete(request); });
+
+  server.on("/file-hash", HTTP_GET, [this](AsyncWebServerRequest *request)
+            { handleGetHash(request); });
+  server.on("/file-hash", HTTP_POST, [this](AsyncWebServerRequest *request)
+            { handleLinkHash(request); });
 }
 
 void FileEndpoint::handleGet(AsyncWebServerRequest *request)
@@ -72,7 +132,7 @@ void FileEndpoint::handleGet(AsyncWebServerRequest *request)
     return;
   }
 
-  File file = LittleFS.open(filePath, FILE_READ);
+  File file = LittleFS.open(fileManager_.resolvePath(filePath), FILE_READ);
   if (!file)
   {
     request->send(500, "text/plain", F("Failed to open file."));
@@ -80,10 +140,41 @@ void FileEndpoint::handleGet(AsyncWebServerRequest *request)
   }
 
   const size_t fileSize = file.size();
-  if (fileSize > kMaxDownloadBytes)
+  const String etag = buildETag(fileSize, file.getLastWrite());
+
+  if (request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == etag)
+  {
+    file.close();
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    request->send(response);
+    return;
+  }
+
+  size_t first = 0;
+  size_t last = fileSize > 0 ? fileSize - 1 : 0;
+  bool isPartial = false;
+  const bool rangeMatchesETag = !request->hasHeader("If-Range") ||
+                                request->getHeader("If-Range")->value() == etag;
+  if (request->hasHeader("Range") && rangeMatchesETag)
+  {
+    bool satisfiable = true;
+    isPartial = parseRange(request->getHeader("Range")->value(), fileSize, first, last, satisfiable);
+    if (!satisfiable)
+    {
+      file.close();
+      AsyncWebServerResponse *response = request->beginResponse(416, "text/plain", F("Requested range not satisfiable."));
+      response->addHeader("Content-Range", "bytes */" + String(fileSize));
+      request->send(response);
+      return;
+    }
+  }
+
+  const size_t contentLength = fileSize > 0 ? last - first + 1 : 0;
+  if (isPartial && !file.seek(first, SeekSet))
   {
     file.close();
-    request->send(413, "text/plain", F("File too large for this endpoint."));
+    request->send(500, "text/plain", F("Failed to seek file."));
     return;
   }
 
@@ -95,10 +186,12 @@ void FileEndpoint::handleGet(AsyncWebServerRequest *request)
 
   auto context = std::make_shared<DownloadContext>();
   context->file = std::move(file);
-  context->remaining = fileSize;
+  context->remaining = contentLength;
 
-  AsyncWebServerResponse *response = request->beginChunkedResponse(
+  // The chunk size follows whatever the TCP send buffer offers (maxLen).
+  AsyncWebServerResponse *response = request->beginResponse(
       "application/octet-stream",
+      contentLength,
       [context](uint8_t *buffer, size_t maxLen, size_t /*index*/) mutable -> size_t
       {
         if (!context || !context->file || context->remaining == 0)
@@ -112,11 +205,6 @@ void FileEndpoint::handleGet(AsyncWebServerRequest *request)
         }
 
         size_t toRead = maxLen;
-        if (toRead > kDownloadChunkSizeBytes)
-        {
-          toRead = kDownloadChunkSizeBytes;
-        }
-
         if (toRead > context->remaining)
         {
           toRead = context->remaining;
@@ -140,6 +228,13 @@ void FileEndpoint::handleGet(AsyncWebServerRequest *request)
         return bytesRead;
       });
 
+  if (isPartial)
+  {
+    response->setCode(206);
+    response->addHeader("Content-Range", "bytes " + String(first) + "-" + String(last) + "/" + String(fileSize));
+  }
+  response->addHeader("Accept-Ranges", "bytes");
+  response->addHeader("ETag", etag);
   response->addHeader("Content-Disposition", "attachment");
   request->send(response);
 }
@@ -162,8 +257,7 @@ void FileEndpoint::handleUploadComplete(AsyncWebServerRequest *request)
 
   request->send(statusCode, "text/plain", message);
 
-  delete context;
-  request->_tempObject = nullptr;
+  releaseUploadContext(request);
 }
 
 void FileEndpoint::handleUploadChunk(AsyncWebServerRequest *request,
@@ -180,7 +274,7 @@ void FileEndpoint::handleUploadChunk(AsyncWebServerRequest *request,
 
   if (!context->error)
   {
-    writeUploadChunk(request, index, len, data);
+    writeUploadChunk(request, len, data);
   }
 
   if (final)
@@ -213,6 +307,72 @@ void FileEndpoint::handleDelete(AsyncWebServerRequest *request)
   request->send(200, "text/plain", F("File was deleted."));
 }
 
+void FileEndpoint::handleGetHash(AsyncWebServerRequest *request)
+{
+  String hash;
+  if (!request->hasParam("hash") ||
+      !AssetStore::normalizeHash(request->getParam("hash")->value(), hash))
+  {
+    request->send(400, "text/plain", F("Missing or invalid 'hash' parameter (SHA-256 hex)."));
+    return;
+  }
+
+  JsonDocument document;
+  JsonObject result = document.to<JsonObject>();
+  result["hash"] = hash;
+  result["stored"] = fileManager_.hasAsset(hash);
+
+  String filePath;
+  if (resolveAndValidateFilePath(request, filePath, false))
+  {
+    AssetStore::Reference reference;
+    result["matchesFile"] = fileManager_.findAsset(filePath, reference) && reference.hash == hash;
+  }
+
+  String json;
+  serializeJson(document, json);
+  request->send(200, "application/json", json);
+}
+
+void FileEndpoint::handleLinkHash(AsyncWebServerRequest *request)
+{
+  String hash;
+  if (!request->hasParam("hash") ||
+      !AssetStore::normalizeHash(request->getParam("hash")->value(), hash))
+  {
+    request->send(400, "text/plain", F("Missing or invalid 'hash' parameter (SHA-256 hex)."));
+    return;
+  }
+
+  String filePath;
+  if (!resolveAndValidateFilePath(request, filePath, true) || !filePath.startsWith(kAssetPathPrefix))
+  {
+    request->send(400, "text/plain", F("Missing or invalid 'file' parameter (use /anims/* path)."));
+    return;
+  }
+
+  AssetStore::Reference reference;
+  if (fileManager_.findAsset(filePath, reference) && reference.hash == hash)
+  {
+    request->send(200, "text/plain", F("File is unchanged."));
+    return;
+  }
+
+  if (!fileManager_.hasAsset(hash))
+  {
+    request->send(404, "text/plain", F("Content is not stored, upload the file."));
+    return;
+  }
+
+  if (!fileManager_.linkAsset(hash, filePath))
+  {
+    request->send(500, "text/plain", F("Failed to link file."));
+    return;
+  }
+
+  request->send(200, "text/plain", F("File was linked to stored content."));
+}
+
 void FileEndpoint::initializeUploadContext(AsyncWebServerRequest *request,
                                            String filename, size_t index)
 {
@@ -221,15 +381,14 @@ void FileEndpoint::initializeUploadContext(AsyncWebServerRequest *request,
     return;
   }
 
-  auto *context = getUploadContext(request);
-  if (context != nullptr)
-  {
-    delete context;
-    context = nullptr;
-  }
+  releaseUploadContext(request);
 
-  context = new UploadContext();
+  auto *context = new UploadContext();
   request->_tempObject = context;
+  // The request destructor only free()s _tempObject; an aborted upload must
+  // still close its file and run the context destructor.
+  request->onDisconnect([this, request]()
+                        { releaseUploadContext(request); });
 
   if (request->hasParam("file", true))
   {
@@ -277,6 +436,24 @@ void FileEndpoint::initializeUploadContext(AsyncWebServerRequest *request,
     return;
   }
 
+  const AsyncWebParameter *crcParam = request->hasParam("crc32", true)
+                                          ? request->getParam("crc32", true)
+                                          : request->getParam("crc32");
+  if (crcParam != nullptr)
+  {
+    const String &crcText = crcParam->value();
+    char *end = nullptr;
+    context->expectedCrc = strtoul(crcText.c_str(), &end, 16);
+    if (crcText.isEmpty() || end == nullptr || *end != '\0')
+    {
+      context->error = true;
+      context->statusCode = 400;
+      context->message = F("Invalid 'crc32' parameter (use hex).");
+      return;
+    }
+    context->hasExpectedCrc = true;
+  }
+
   context->tempPath = context->targetPath + F(".tmp");
   if (fileManager_.exists(context->tempPath) &&
       !fileManager_.removeFile(context->tempPath))
@@ -284,10 +461,18 @@ void FileEndpoint::initializeUploadContext(AsyncWebServerRequest *request,
     context->error = true;
     context->statusCode = 500;
     context->message = F("Failed to prepare temporary file.");
+    return;
+  }
+
+  if (!context->writer.open(LittleFS, context->tempPath))
+  {
+    context->error = true;
+    context->statusCode = 500;
+    context->message = F("Failed to open temporary file.");
   }
 }
 
-void FileEndpoint::writeUploadChunk(AsyncWebServerRequest *request, size_t index,
+void FileEndpoint::writeUploadChunk(AsyncWebServerRequest *request,
                                     size_t len, uint8_t *data)
 {
   auto *context = getUploadContext(request);
@@ -296,8 +481,7 @@ void FileEndpoint::writeUploadChunk(AsyncWebServerRequest *request, size_t index
     return;
   }
 
-  const bool append = index > 0;
-  if (!fileManager_.writeFile(context->tempPath, data, len, append))
+  if (!context->writer.write(data, len))
   {
     context->error = true;
     context->statusCode = 500;
@@ -313,8 +497,27 @@ void FileEndpoint::finalizeUpload(AsyncWebServerRequest *request)
     return;
   }
 
+  if (!context->error && !context->writer.close())
+  {
+    context->error = true;
+    context->statusCode = 500;
+    context->message = F("Failed to write uploaded data.");
+  }
+
+  if (!context->error && context->hasExpectedCrc &&
+      context->writer.crc32() != context->expectedCrc)
+  {
+    char message[64];
+    snprintf(message, sizeof(message), "Checksum mismatch (received crc32 %08lx).",
+             static_cast<unsigned long>(context->writer.crc32()));
+    context->error = true;
+    context->statusCode = 400;
+    context->message = message;
+  }
+
   if (context->error)
   {
+    context->writer.abort();
     if (fileManager_.exists(context->tempPath))
     {
       fileManager_.removeFile(context->tempPath);
@@ -322,6 +525,28 @@ void FileEndpoint::finalizeUpload(AsyncWebServerRequest *request)
     return;
   }
 
+  // Animations go to the content-addressed store, other files (web UI) stay plain
+  // because they are served straight from LittleFS.
+  if (context->targetPath.startsWith(kAssetPathPrefix))
+  {
+    bool deduplicated = false;
+    if (!fileManager_.storeAsset(context->tempPath, context->targetPath, deduplicated))
+    {
+      context->error = true;
+      context->statusCode = 500;
+      context->message = F("Failed to save file.");
+      fileManager_.removeFile(context->tempPath);
+      return;
+    }
+
+    context->message = context->overwrite ? F("File was updated.") : F("File was created.");
+    if (deduplicated)
+    {
+      context->message += F(" Content was already stored.");
+    }
+    return;
+  }
+
   if (context->overwrite && fileManager_.exists(context->targetPath) &&
       !fileManager_.removeFile(context->targetPath))
   {
@@ -399,3 +624,22 @@ FileEndpoint::UploadContext *FileEndpoint::getUploadContext(
 {
   return static_cast<UploadContext *>(request->_tempObject);
 }
+
+void FileEndpoint::releaseUploadContext(AsyncWebServerRequest *request)
+{
+  auto *context = getUploadContext(request);
+  if (context == nullptr)
+  {
+    return;
+  }
+
+  const bool incomplete = context->writer.isOpen();
+  const String tempPath = context->tempPath;
+  delete context;
+  request->_tempObject = nullptr;
+
+  if (incomplete && !tempPath.isEmpty() && fileManager_.exists(tempPath))
+  {
+    fileManager_.removeFile(tempPath);
+  }
+}
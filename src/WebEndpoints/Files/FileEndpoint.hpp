@@ -5,6 +5,7 @@
 
 #include <Arduino.h>
 
+#include "BufferedFileWriter.hpp"
 #include "FileManager.hpp"
 
 class FileEndpoint {
@@ -18,6 +19,9 @@ private:
     String targetPath;
     String tempPath;
     bool overwrite = false;
+    bool hasExpectedCrc = false;
+    uint32_t expectedCrc = 0;
+    BufferedFileWriter writer;
     bool error = false;
     int statusCode = 500;
     String message;
@@ -27,15 +31,18 @@ private:
   void handleUploadComplete(AsyncWebServerRequest *request);
   void handleUploadChunk(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final);
   void handleDelete(AsyncWebServerRequest *request);
+  void handleGetHash(AsyncWebServerRequest *request);
+  void handleLinkHash(AsyncWebServerRequest *request);
 
   void initializeUploadContext(AsyncWebServerRequest *request, String filename, size_t index);
-  void writeUploadChunk(AsyncWebServerRequest *request, size_t index, size_t len, uint8_t *data);
+  void writeUploadChunk(AsyncWebServerRequest *request, size_t len, uint8_t *data);
   void finalizeUpload(AsyncWebServerRequest *request);
 
   bool resolveAndValidateFilePath(AsyncWebServerRequest *request, String &resolvedPath, bool animationsOnly) const;
   bool normalizeFilePath(const String &input, String &normalizedPath, bool animationsOnly) const;
   void sanitizeFilename(String &filename) const;
   UploadContext *getUploadContext(AsyncWebServerRequest *request) const;
+  void releaseUploadContext(AsyncWebServerRequest *request);
 
   FileManager &fileManager_;
   bool allowAllFileChanges_;
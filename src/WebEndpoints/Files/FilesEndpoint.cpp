@@ -2,6 +2,20 @@
 
 #include <ArduinoJson.h>
 
+#include <memory>
+
+#include "Web/JsonArrayStream.hpp"
+
+namespace
+{
+constexpr size_t kMaxPageSize = 200;
+
+String getQueryParam(AsyncWebServerRequest *request, const char *name)
+{
+  return request->hasParam(name) ? request->getParam(name)->value() : String();
+}
+} // namespace
+
 FilesEndpoint::FilesEndpoint(FileManager &fileManager)
     : fileManager_(fileManager)
 {
@@ -17,24 +31,49 @@ void FilesEndpoint::registerEndpoint(AsyncWebServer &server)
 
 void FilesEndpoint::handleGet(AsyncWebServerRequest *request)
 {
-  const String filter = request->hasParam("filter")
-                            ? request->getParam("filter")->value()
-                            : String();
-  const auto emotionFiles = fileManager_.getFiles(filter);
-
-  JsonDocument document;
-  JsonArray files = document.to<JsonArray>();
+  FileQuery query = FileQuery::fromFilter(getQueryParam(request, "filter"));
+  if (request->hasParam("prefix"))
+  {
+    query.prefix = getQueryParam(request, "prefix");
+  }
+  if (request->hasParam("ext"))
+  {
+    query.extension = getQueryParam(request, "ext");
+  }
+  if (request->hasParam("contains"))
+  {
+    query.contains = getQueryParam(request, "contains");
+  }
+  query.normalize();
 
-  for (const auto &file : emotionFiles)
+  const long offset = getQueryParam(request, "offset").toInt();
+  query.offset = offset > 0 ? static_cast<size_t>(offset) : 0;
+  // Without paging parameters the whole (streamed) listing is returned, as the
+  // web UI expects. A paged request is bounded: an invalid or larger limit
+  // gets the maximum page size.
+  if (request->hasParam("limit") || request->hasParam("offset"))
   {
-    JsonObject fileObject = files.add<JsonObject>();
-    file.serialize(fileObject);
+    const long limit = getQueryParam(request, "limit").toInt();
+    query.limit = limit > 0 && static_cast<size_t>(limit) < kMaxPageSize ? static_cast<size_t>(limit) : kMaxPageSize;
   }
 
-  String json;
-  serializeJson(document, json);
+  const size_t totalCount = fileManager_.countFiles(query);
+  auto cursor = std::make_shared<FileCursor>(fileManager_.openCursor(query));
 
-  request->send(200, "application/json", json);
+  AsyncWebServerResponse *response = JsonArrayStream::beginResponse(
+      request,
+      [cursor](JsonDocument &element)
+      {
+        Model::File file;
+        if (!cursor->next(file))
+        {
+          return false;
+        }
+        file.serialize(element.to<JsonObject>());
+        return true;
+      });
+  response->addHeader("X-Total-Count", String(totalCount));
+  request->send(response);
 }
 
 void FilesEndpoint::handleGetInfo(AsyncWebServerRequest *request)
@@ -55,6 +94,16 @@ void FilesEndpoint::handleGetInfo(AsyncWebServerRequest *request)
   info["usedSizeBytes"] = usedSizeBytes;
   info["usedPercentage"] = usedPercentage;
 
+  const AssetStore::Stats assetStats = fileManager_.getAssetStats();
+  JsonObject assets = info["assets"].to<JsonObject>();
+  assets["storedFiles"] = assetStats.blobCount;
+  assets["storedBytes"] = assetStats.storedBytes;
+  assets["references"] = assetStats.referenceCount;
+  assets["referencedBytes"] = assetStats.referencedBytes;
+  assets["savedBytes"] = assetStats.referencedBytes - assetStats.storedBytes;
+  assets["deduplicatedUploads"] = assetStats.deduplicatedUploads;
+  assets["skippedUploads"] = assetStats.skippedUploads;
+
   String json;
   serializeJson(document, json);
 
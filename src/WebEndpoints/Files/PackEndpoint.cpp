@@ -0,0 +1,132 @@
+#include "WebEndpoints/Files/PackEndpoint.hpp"
+
+#include <vector>
+
+PackEndpoint::PackEndpoint(FileManager &fileManager, EmotionState &emotionState,
+                           EarController &earController,
+                           std::function<void()> onSettingsChanged,
+                           bool allowAllFileChanges)
+    : fileManager_(fileManager),
+      emotionState_(emotionState),
+      earController_(earController),
+      onSettingsChanged_(onSettingsChanged),
+      allowAllFileChanges_(allowAllFileChanges)
+{
+}
+
+void PackEndpoint::registerEndpoint(AsyncWebServer &server)
+{
+  server.on(
+      "/pack", HTTP_POST,
+      [this](AsyncWebServerRequest *request)
+      {
+        handleUploadComplete(request);
+      },
+      [this](AsyncWebServerRequest *request, String filename, size_t index,
+             uint8_t *data, size_t len, bool final)
+      {
+        handleUploadChunk(request, index, data, len, final);
+      });
+}
+
+void PackEndpoint::handleUploadComplete(AsyncWebServerRequest *request)
+{
+  auto *context = getUploadContext(request);
+  if (context == nullptr || !context->finished)
+  {
+    request->send(400, "text/plain", F("No pack uploaded."));
+    releaseUploadContext(request);
+    return;
+  }
+
+  request->send(context->statusCode, "text/plain", context->message);
+  releaseUploadContext(request);
+}
+
+void PackEndpoint::handleUploadChunk(AsyncWebServerRequest *request, size_t index,
+                                     uint8_t *data, size_t len, bool final)
+{
+  if (index == 0)
+  {
+    releaseUploadContext(request);
+    request->_tempObject = new UploadContext(fileManager_, allowAllFileChanges_);
+    // The request destructor only free()s _tempObject; an aborted upload must
+    // still run the installer destructor so staged files are removed.
+    request->onDisconnect([this, request]()
+                          { releaseUploadContext(request); });
+  }
+
+  auto *context = getUploadContext(request);
+  if (context == nullptr || context->finished)
+  {
+    return;
+  }
+
+  if (len > 0)
+  {
+    context->installer.write(data, len);
+  }
+
+  if (final)
+  {
+    finalizeUpload(*context);
+  }
+}
+
+void PackEndpoint::finalizeUpload(UploadContext &context)
+{
+  context.finished = true;
+
+  std::vector<EmotionDefinition> emotions;
+  if (!context.installer.finish(emotions))
+  {
+    context.statusCode = context.installer.getStatusCode();
+    context.message = context.installer.getError();
+    return;
+  }
+
+  const size_t fileCount = context.installer.getFileCount();
+  if (!context.installer.commit())
+  {
+    context.statusCode = context.installer.getStatusCode();
+    context.message = context.installer.getError();
+    return;
+  }
+
+  const auto emotionLock = emotionState_.lock();
+  for (const auto &emotion : emotions)
+  {
+    emotionState_.upsertEmotionDefinition(emotion, true);
+  }
+
+  if (!emotions.empty())
+  {
+    earController_.applyEmotionEarColor(emotionState_.getCurrentEmotionDefinition());
+    if (onSettingsChanged_)
+    {
+      onSettingsChanged_();
+    }
+  }
+
+  context.statusCode = 200;
+  context.message = String(F("Pack installed: ")) + fileCount + F(" file(s), ") +
+                    emotions.size() + F(" emotion(s).");
+}
+
+PackEndpoint::UploadContext *PackEndpoint::getUploadContext(
+    AsyncWebServerRequest *request) const
+{
+  return static_cast<UploadContext *>(request->_tempObject);
+}
+
+void PackEndpoint::releaseUploadContext(AsyncWebServerRequest *request)
+{
+  auto *context = getUploadContext(request);
+  if (context == nullptr)
+  {
+    return;
+  }
+
+  delete context;
+  request->_tempObject = nullptr;
+}
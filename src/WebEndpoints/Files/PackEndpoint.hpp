@@ -0,0 +1,47 @@
+#ifndef WEB_ENDPOINTS_FILES_PACK_ENDPOINT_HPP
+#define WEB_ENDPOINTS_FILES_PACK_ENDPOINT_HPP
+
+#include <ESPAsyncWebServer.h>
+
+#include <Arduino.h>
+#include <functional>
+
+#include "EarController.hpp"
+#include "EmotionState.hpp"
+#include "FileManager.hpp"
+#include "PackInstaller.hpp"
+
+// Installs an animation pack (tar of files plus an optional emotions.json) in one upload.
+class PackEndpoint {
+public:
+  PackEndpoint(FileManager &fileManager, EmotionState &emotionState,
+               EarController &earController, std::function<void()> onSettingsChanged,
+               bool allowAllFileChanges);
+
+  void registerEndpoint(AsyncWebServer &server);
+
+private:
+  struct UploadContext {
+    UploadContext(FileManager &fileManager, bool allowAllFileChanges)
+        : installer(fileManager, allowAllFileChanges) {}
+
+    PackInstaller installer;
+    bool finished = false;
+    int statusCode = 500;
+    String message;
+  };
+
+  void handleUploadComplete(AsyncWebServerRequest *request);
+  void handleUploadChunk(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len, bool final);
+  void finalizeUpload(UploadContext &context);
+  UploadContext *getUploadContext(AsyncWebServerRequest *request) const;
+  void releaseUploadContext(AsyncWebServerRequest *request);
+
+  FileManager &fileManager_;
+  EmotionState &emotionState_;
+  EarController &earController_;
+  std::function<void()> onSettingsChanged_;
+  bool allowAllFileChanges_;
+};
+
+#endif // WEB_ENDPOINTS_FILES_PACK_ENDPOINT_HPP
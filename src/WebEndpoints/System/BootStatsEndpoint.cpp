@@ -0,0 +1,24 @@
+#include "WebEndpoints/System/BootStatsEndpoint.hpp"
+
+#include <ArduinoJson.h>
+
+BootStatsEndpoint::BootStatsEndpoint(const BootSequencer &bootSequencer)
+    : bootSequencer_(bootSequencer)
+{
+}
+
+void BootStatsEndpoint::registerEndpoint(AsyncWebServer &server)
+{
+  server.on("/boot-stats", HTTP_GET, [this](AsyncWebServerRequest *request)
+            { handleGet(request); });
+}
+
+void BootStatsEndpoint::handleGet(AsyncWebServerRequest *request)
+{
+  JsonDocument document;
+  bootSequencer_.serialize(document.to<JsonObject>());
+
+  String json;
+  serializeJson(document, json);
+  request->send(200, "application/json", json);
+}
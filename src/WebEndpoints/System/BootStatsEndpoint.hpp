@@ -0,0 +1,20 @@
+#ifndef WEB_ENDPOINTS_SYSTEM_BOOT_STATS_ENDPOINT_HPP
+#define WEB_ENDPOINTS_SYSTEM_BOOT_STATS_ENDPOINT_HPP
+
+#include <ESPAsyncWebServer.h>
+
+#include "BootSequencer.hpp"
+
+class BootStatsEndpoint {
+public:
+  explicit BootStatsEndpoint(const BootSequencer &bootSequencer);
+
+  void registerEndpoint(AsyncWebServer &server);
+
+private:
+  void handleGet(AsyncWebServerRequest *request);
+
+  const BootSequencer &bootSequencer_;
+};
+
+#endif // WEB_ENDPOINTS_SYSTEM_BOOT_STATS_ENDPOINT_HPP
@@ -0,0 +1,32 @@
+#include "WebEndpoints/System/DisplayStatsEndpoint.hpp"
+
+#include <ArduinoJson.h>
+
+DisplayStatsEndpoint::DisplayStatsEndpoint(FrameStats &frameStats)
+    : frameStats_(frameStats)
+{
+}
+
+void DisplayStatsEndpoint::registerEndpoint(AsyncWebServer &server)
+{
+  server.on("/display-stats", HTTP_GET, [this](AsyncWebServerRequest *request)
+            { handleGet(request); });
+  server.on("/display-stats", HTTP_DELETE, [this](AsyncWebServerRequest *request)
+            { handleDelete(request); });
+}
+
+void DisplayStatsEndpoint::handleGet(AsyncWebServerRequest *request)
+{
+  JsonDocument document;
+  frameStats_.serialize(document.to<JsonObject>());
+
+  String json;
+  serializeJson(document, json);
+  request->send(200, "application/json", json);
+}
+
+void DisplayStatsEndpoint::handleDelete(AsyncWebServerRequest *request)
+{
+  frameStats_.requestReset();
+  request->send(200, "text/plain", F("Display stats reset."));
+}
@@ -0,0 +1,21 @@
+#ifndef WEB_ENDPOINTS_SYSTEM_DISPLAY_STATS_ENDPOINT_HPP
+#define WEB_ENDPOINTS_SYSTEM_DISPLAY_STATS_ENDPOINT_HPP
+
+#include <ESPAsyncWebServer.h>
+
+#include "FaceDisplay/FrameStats.hpp"
+
+class DisplayStatsEndpoint {
+public:
+  explicit DisplayStatsEndpoint(FrameStats &frameStats);
+
+  void registerEndpoint(AsyncWebServer &server);
+
+private:
+  void handleGet(AsyncWebServerRequest *request);
+  void handleDelete(AsyncWebServerRequest *request);
+
+  FrameStats &frameStats_;
+};
+
+#endif // WEB_ENDPOINTS_SYSTEM_DISPLAY_STATS_ENDPOINT_HPP
@@ -0,0 +1,155 @@
+#include "WebEndpoints/System/EventsEndpoint.hpp"
+
+#include <ArduinoJson.h>
+
+namespace
+{
+constexpr unsigned long kCheckIntervalMs = 200;
+constexpr size_t kMaxEventBytes = 192;
+}
+
+EventsEndpoint::EventsEndpoint(FanController &fanController,
+                               LedBrightnessController &brightnessController,
+                               TiltController &tiltController,
+                               const StateStore &stateStore)
+    : fanController_(fanController),
+      brightnessController_(brightnessController),
+      tiltController_(tiltController),
+      stateStore_(stateStore),
+      events_("/events"),
+      snapshotRequested_(false),
+      lastCheckMillis_(0),
+      nextEventId_(1)
+{
+}
+
+void EventsEndpoint::registerEndpoint(AsyncWebServer &server)
+{
+  // Runs on the TCP task; the snapshot itself is read and sent from update().
+  events_.onConnect([this](AsyncEventSourceClient *client)
+                    { snapshotRequested_ = true; });
+  server.addHandler(&events_);
+}
+
+void EventsEndpoint::update()
+{
+  const unsigned long now = millis();
+  if (now - lastCheckMillis_ < kCheckIntervalMs)
+  {
+    return;
+  }
+  lastCheckMillis_ = now;
+
+  if (events_.count() == 0)
+  {
+    return;
+  }
+
+  // Emotion and power come from the published snapshot; power is sampled once
+  // by SystemPowerController, which already filters sensor noise.
+  StateStore::Snapshot state;
+  stateStore_.read(state);
+
+  // A new client gets every value once; existing clients see it as a refresh.
+  if (snapshotRequested_.exchange(false))
+  {
+    sendEmotion(state);
+    sendFan();
+    sendBrightness();
+    sendTilt();
+    if (state.hasPower)
+    {
+      sendPower(state);
+    }
+    return;
+  }
+
+  if (state.emotionRevision != sent_.emotionRevision)
+  {
+    sendEmotion(state);
+  }
+  if (fanController_.getDutyCycle() != sent_.fanDutyCycle)
+  {
+    sendFan();
+  }
+  if (brightnessController_.getBrightness() != sent_.brightness)
+  {
+    sendBrightness();
+  }
+  if (tiltController_.getPosition() != sent_.tilt)
+  {
+    sendTilt();
+  }
+  if (state.hasPower &&
+      (!sent_.hasPower || state.voltage != sent_.voltage || state.currentMilliamps != sent_.currentMilliamps))
+  {
+    sendPower(state);
+  }
+}
+
+void EventsEndpoint::sendEmotion(const StateStore::Snapshot &state)
+{
+  sent_.emotionRevision = state.emotionRevision;
+
+  JsonDocument document;
+  document["id"] = state.emotionId;
+  // Plain paths have no definition and so no name.
+  document["name"] = state.emotionId != 0 ? state.emotionName : "";
+  document["path"] = state.emotionPath;
+  send("emotion", document);
+}
+
+void EventsEndpoint::sendFan()
+{
+  sent_.fanDutyCycle = fanController_.getDutyCycle();
+
+  JsonDocument document;
+  document["dutyCycle"] = sent_.fanDutyCycle;
+  document["dutyCyclePercent"] = fanController_.getDutyCyclePercent();
+  send("fan", document);
+}
+
+void EventsEndpoint::sendBrightness()
+{
+  sent_.brightness = brightnessController_.getBrightness();
+
+  JsonDocument document;
+  document["brightness"] = sent_.brightness;
+  document["brightnessPercent"] = brightnessController_.getBrightnessPercent();
+  send("brightness", document);
+}
+
+void EventsEndpoint::sendTilt()
+{
+  sent_.tilt = tiltController_.getPosition();
+
+  JsonDocument document;
+  document["enabled"] = tiltController_.isEnabled();
+  document["position"] = TiltController::getPositionName(sent_.tilt);
+  send("tilt", document);
+}
+
+void EventsEndpoint::sendPower(const StateStore::Snapshot &state)
+{
+  sent_.hasPower = true;
+  sent_.voltage = state.voltage;
+  sent_.currentMilliamps = state.currentMilliamps;
+
+  JsonDocument document;
+  document["voltage"] = sent_.voltage;
+  document["currentMilliamps"] = sent_.currentMilliamps;
+  send("power", document);
+}
+
+void EventsEndpoint::send(const char *event, JsonDocument &document)
+{
+  char message[kMaxEventBytes];
+  const size_t length = serializeJson(document, message, sizeof(message));
+  if (length == 0 || length >= sizeof(message) - 1)
+  {
+    Serial.printf("[W] Event '%s' is too large to send\n", event);
+    return;
+  }
+
+  events_.send(message, event, nextEventId_++);
+}
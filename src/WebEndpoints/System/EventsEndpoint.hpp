@@ -0,0 +1,55 @@
+#ifndef WEB_ENDPOINTS_SYSTEM_EVENTS_ENDPOINT_HPP
+#define WEB_ENDPOINTS_SYSTEM_EVENTS_ENDPOINT_HPP
+
+#include <ESPAsyncWebServer.h>
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "FanController.hpp"
+#include "LedBrightnessController.hpp"
+#include "StateStore.hpp"
+#include "TiltController.hpp"
+
+// Server-Sent Events on /events. State is compared against the last sent
+// snapshot from the main loop, so bursts of changes are coalesced into one
+// event per kind and check interval instead of clients polling every endpoint.
+class EventsEndpoint {
+public:
+  EventsEndpoint(FanController &fanController,
+                 LedBrightnessController &brightnessController, TiltController &tiltController,
+                 const StateStore &stateStore);
+
+  void registerEndpoint(AsyncWebServer &server);
+  void update();
+
+private:
+  struct Snapshot {
+    uint32_t emotionRevision = 0;
+    int fanDutyCycle = -1;
+    int brightness = -1;
+    TiltController::Position tilt = TiltController::Position::Neutral;
+    bool hasPower = false;
+    float voltage = 0.0f;
+    float currentMilliamps = 0.0f;
+  };
+
+  void sendEmotion(const StateStore::Snapshot &state);
+  void sendFan();
+  void sendBrightness();
+  void sendTilt();
+  void sendPower(const StateStore::Snapshot &state);
+  void send(const char *event, JsonDocument &document);
+
+  FanController &fanController_;
+  LedBrightnessController &brightnessController_;
+  TiltController &tiltController_;
+  const StateStore &stateStore_;
+  AsyncEventSource events_;
+  Snapshot sent_;
+  std::atomic<bool> snapshotRequested_;
+  unsigned long lastCheckMillis_;
+  uint32_t nextEventId_;
+};
+
+#endif // WEB_ENDPOINTS_SYSTEM_EVENTS_ENDPOINT_HPP
@@ -0,0 +1,127 @@
+#include "WebEndpoints/System/FacePreviewEndpoint.hpp"
+
+#include <ArduinoJson.h>
+
+#include <memory>
+
+namespace
+{
+constexpr uint32_t kCleanupIntervalMs = 1000;
+}
+
+FacePreviewEndpoint::FacePreviewEndpoint(FramePreview &framePreview)
+    : framePreview_(framePreview),
+      socket_("/face-preview"),
+      lastCleanupMillis_(0)
+{
+}
+
+void FacePreviewEndpoint::registerEndpoint(AsyncWebServer &server)
+{
+  socket_.onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type,
+                         void *arg, uint8_t *data, size_t length)
+                  { handleEvent(client, type); });
+  server.addHandler(&socket_);
+  server.on("/face-preview-stats", HTTP_GET, [this](AsyncWebServerRequest *request)
+            { handleGetStats(request); });
+}
+
+void FacePreviewEndpoint::update()
+{
+  const uint32_t now = millis();
+  if (now - lastCleanupMillis_ >= kCleanupIntervalMs)
+  {
+    lastCleanupMillis_ = now;
+    socket_.cleanupClients();
+  }
+
+  // The shadow framebuffer only exists while someone is watching.
+  framePreview_.setActive(socket_.count() > 0);
+
+  const uint8_t *frame = nullptr;
+  size_t length = 0;
+  if (!framePreview_.peekFrame(frame, length))
+  {
+    return;
+  }
+
+  // One copy shared by every client. A client whose queue is full
+  // (WS_MAX_QUEUED_MESSAGES, see platformio.ini) skips the frame until it
+  // catches up; only the frames actually queued count as its bandwidth.
+  const AsyncWebSocketSharedBuffer buffer = std::make_shared<std::vector<uint8_t>>(frame, frame + length);
+  framePreview_.releaseFrame();
+
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  for (auto &stats : clientStats_)
+  {
+    if (stats.client->queueIsFull() || !stats.client->binary(buffer))
+    {
+      ++stats.framesDropped;
+      continue;
+    }
+    stats.bytesSent += length;
+    ++stats.framesSent;
+  }
+}
+
+void FacePreviewEndpoint::handleEvent(AsyncWebSocketClient *client, AwsEventType type)
+{
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  if (type == WS_EVT_CONNECT)
+  {
+    // Slow viewers skip frames instead of being disconnected.
+    client->setCloseClientOnQueueFull(false);
+
+    ClientStats stats;
+    stats.client = client;
+    stats.id = client->id();
+    stats.connectedMillis = millis();
+    clientStats_.push_back(stats);
+    return;
+  }
+
+  if (type == WS_EVT_DISCONNECT)
+  {
+    for (size_t i = 0; i < clientStats_.size(); ++i)
+    {
+      if (clientStats_[i].id == client->id())
+      {
+        clientStats_.erase(clientStats_.begin() + i);
+        break;
+      }
+    }
+  }
+}
+
+void FacePreviewEndpoint::handleGetStats(AsyncWebServerRequest *request)
+{
+  JsonDocument document;
+  JsonObject result = document.to<JsonObject>();
+  result["active"] = framePreview_.isActive();
+  result["maxFps"] = FramePreview::kMaxFps;
+  result["encodedFrames"] = framePreview_.getEncodedFrameCount();
+  result["lastFrameBytes"] = framePreview_.getLastFrameBytes();
+
+  JsonArray clients = result["clients"].to<JsonArray>();
+  const uint32_t now = millis();
+  {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    for (const auto &stats : clientStats_)
+    {
+      JsonObject client = clients.add<JsonObject>();
+      const uint32_t connectedMillis = now - stats.connectedMillis;
+      client["id"] = stats.id;
+      client["connectedSeconds"] = connectedMillis / 1000;
+      client["bytesSent"] = stats.bytesSent;
+      client["framesSent"] = stats.framesSent;
+      client["framesDropped"] = stats.framesDropped;
+      client["bytesPerSecond"] = connectedMillis > 0
+                                     ? static_cast<uint32_t>(stats.bytesSent * 1000ULL / connectedMillis)
+                                     : 0;
+    }
+  }
+
+  String json;
+  serializeJson(document, json);
+  request->send(200, "application/json", json);
+}
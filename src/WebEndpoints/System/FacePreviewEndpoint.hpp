@@ -0,0 +1,46 @@
+#ifndef WEB_ENDPOINTS_SYSTEM_FACE_PREVIEW_ENDPOINT_HPP
+#define WEB_ENDPOINTS_SYSTEM_FACE_PREVIEW_ENDPOINT_HPP
+
+#include <ESPAsyncWebServer.h>
+
+#include <mutex>
+#include <vector>
+
+#include "FaceDisplay/FramePreview.hpp"
+
+// Streams the face canvas to WebSocket clients on /face-preview and reports
+// per-client bandwidth on /face-preview-stats.
+class FacePreviewEndpoint {
+public:
+  explicit FacePreviewEndpoint(FramePreview &framePreview);
+
+  void registerEndpoint(AsyncWebServer &server);
+  // Sends the latest encoded frame; runs on the loop task like the face renderer.
+  void update();
+
+private:
+  // Kept from the socket events, so update() never walks the client list
+  // itself (AsyncTCP adds and removes clients concurrently). The server raises
+  // the disconnect event before it frees a client, and the event waits for
+  // statsMutex_, so `client` stays valid while the mutex is held.
+  struct ClientStats {
+    AsyncWebSocketClient *client = nullptr;
+    uint32_t id = 0;
+    uint32_t connectedMillis = 0;
+    uint64_t bytesSent = 0;
+    uint32_t framesSent = 0;
+    // Frames skipped because this client's queue was still full.
+    uint32_t framesDropped = 0;
+  };
+
+  void handleEvent(AsyncWebSocketClient *client, AwsEventType type);
+  void handleGetStats(AsyncWebServerRequest *request);
+
+  FramePreview &framePreview_;
+  AsyncWebSocket socket_;
+  std::vector<ClientStats> clientStats_;
+  std::mutex statsMutex_;
+  uint32_t lastCleanupMillis_;
+};
+
+#endif // WEB_ENDPOINTS_SYSTEM_FACE_PREVIEW_ENDPOINT_HPP
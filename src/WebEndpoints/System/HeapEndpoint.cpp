@@ -1,12 +1,36 @@
 #include "WebEndpoints/System/HeapEndpoint.hpp"
 
+#include <ArduinoJson.h>
+
+#include "HeapMonitor.hpp"
+
 void HeapEndpoint::registerEndpoint(AsyncWebServer &server)
 {
   server.on("/heap", HTTP_GET, [this](AsyncWebServerRequest *request)
             { handleGet(request); });
+  server.on("/heap-info", HTTP_GET, [this](AsyncWebServerRequest *request)
+            { handleGetInfo(request); });
+  server.on("/heap-info", HTTP_DELETE, [this](AsyncWebServerRequest *request)
+            { handleDeleteInfo(request); });
 }
 
 void HeapEndpoint::handleGet(AsyncWebServerRequest *request)
 {
   request->send(200, "text/plain", String(ESP.getFreeHeap()));
 }
+
+void HeapEndpoint::handleGetInfo(AsyncWebServerRequest *request)
+{
+  JsonDocument document;
+  HeapMonitor::serialize(document.to<JsonObject>());
+
+  String json;
+  serializeJson(document, json);
+  request->send(200, "application/json", json);
+}
+
+void HeapEndpoint::handleDeleteInfo(AsyncWebServerRequest *request)
+{
+  HeapMonitor::resetCounters();
+  request->send(200, "text/plain", F("Allocation counters reset."));
+}
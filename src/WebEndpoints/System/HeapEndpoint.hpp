@@ -11,6 +11,8 @@ public:
 
 private:
   void handleGet(AsyncWebServerRequest *request);
+  void handleGetInfo(AsyncWebServerRequest *request);
+  void handleDeleteInfo(AsyncWebServerRequest *request);
 };
 
 #endif // WEB_ENDPOINTS_SYSTEM_HEAP_ENDPOINT_HPP
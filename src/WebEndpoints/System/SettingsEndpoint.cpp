@@ -0,0 +1,61 @@
+#include "WebEndpoints/System/SettingsEndpoint.hpp"
+
+#include <ArduinoJson.h>
+
+SettingsEndpoint::SettingsEndpoint(SettingsStorage &settingsStorage,
+                                   std::function<void()> onSettingsChanged)
+    : settingsStorage_(settingsStorage),
+      onSettingsChanged_(onSettingsChanged)
+{
+}
+
+void SettingsEndpoint::registerEndpoint(AsyncWebServer &server)
+{
+  server.on("/settings", HTTP_GET, [this](AsyncWebServerRequest *request)
+            { handleGet(request); });
+  addJsonHandler(
+      server,
+      HTTP_PUT,
+      "/settings",
+      [this](AsyncWebServerRequest *request, JsonDocument &doc)
+      {
+        return handlePut(request, doc);
+      },
+      kMaxSettingsBodyBytes);
+}
+
+void SettingsEndpoint::handleGet(AsyncWebServerRequest *request)
+{
+  JsonDocument document;
+  settingsStorage_.exportJson(document.to<JsonObject>());
+
+  String json;
+  serializeJson(document, json);
+  request->send(200, "application/json", json);
+}
+
+Response SettingsEndpoint::handlePut(AsyncWebServerRequest *request, JsonDocument &doc)
+{
+  if (!doc.is<JsonObject>())
+  {
+    return {F("JSON object expected."), "text/plain", 400};
+  }
+
+  String error;
+  if (!settingsStorage_.importJson(doc.as<JsonObject>(), error))
+  {
+    return {error, "text/plain", 400};
+  }
+
+  if (onSettingsChanged_)
+  {
+    onSettingsChanged_();
+  }
+
+  JsonDocument document;
+  settingsStorage_.exportJson(document.to<JsonObject>());
+
+  String json;
+  serializeJson(document, json);
+  return {json};
+}
@@ -0,0 +1,31 @@
+#ifndef WEB_ENDPOINTS_SYSTEM_SETTINGS_ENDPOINT_HPP
+#define WEB_ENDPOINTS_SYSTEM_SETTINGS_ENDPOINT_HPP
+
+#include <ESPAsyncWebServer.h>
+#include <functional>
+
+#include "Web/JsonEndpoint.hpp"
+#include "SettingsStorage.hpp"
+
+// JSON export/import of the persisted settings. The device itself stores them
+// in the binary settings journal.
+class SettingsEndpoint : public JsonEndpoint
+{
+public:
+  SettingsEndpoint(SettingsStorage &settingsStorage, std::function<void()> onSettingsChanged);
+
+  void registerEndpoint(AsyncWebServer &server);
+
+  // A settings export with many emotions outgrows kMaxJsonBodyBytes; importing
+  // it back has to fit.
+  static constexpr size_t kMaxSettingsBodyBytes = 32 * 1024;
+
+private:
+  void handleGet(AsyncWebServerRequest *request);
+  Response handlePut(AsyncWebServerRequest *request, JsonDocument &doc);
+
+  SettingsStorage &settingsStorage_;
+  std::function<void()> onSettingsChanged_;
+};
+
+#endif // WEB_ENDPOINTS_SYSTEM_SETTINGS_ENDPOINT_HPP
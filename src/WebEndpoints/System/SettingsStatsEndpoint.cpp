@@ -0,0 +1,24 @@
+#include "WebEndpoints/System/SettingsStatsEndpoint.hpp"
+
+#include <ArduinoJson.h>
+
+SettingsStatsEndpoint::SettingsStatsEndpoint(SettingsStorage &settingsStorage)
+    : settingsStorage_(settingsStorage)
+{
+}
+
+void SettingsStatsEndpoint::registerEndpoint(AsyncWebServer &server)
+{
+  server.on("/settings-stats", HTTP_GET, [this](AsyncWebServerRequest *request)
+            { handleGet(request); });
+}
+
+void SettingsStatsEndpoint::handleGet(AsyncWebServerRequest *request)
+{
+  JsonDocument document;
+  settingsStorage_.serializeStats(document.to<JsonObject>());
+
+  String json;
+  serializeJson(document, json);
+  request->send(200, "application/json", json);
+}
@@ -0,0 +1,20 @@
+#ifndef WEB_ENDPOINTS_SYSTEM_SETTINGS_STATS_ENDPOINT_HPP
+#define WEB_ENDPOINTS_SYSTEM_SETTINGS_STATS_ENDPOINT_HPP
+
+#include <ESPAsyncWebServer.h>
+
+#include "SettingsStorage.hpp"
+
+class SettingsStatsEndpoint {
+public:
+  explicit SettingsStatsEndpoint(SettingsStorage &settingsStorage);
+
+  void registerEndpoint(AsyncWebServer &server);
+
+private:
+  void handleGet(AsyncWebServerRequest *request);
+
+  SettingsStorage &settingsStorage_;
+};
+
+#endif // WEB_ENDPOINTS_SYSTEM_SETTINGS_STATS_ENDPOINT_HPP
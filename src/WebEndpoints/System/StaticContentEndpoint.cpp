@@ -1,5 +1,20 @@
 #include "WebEndpoints/System/StaticContentEndpoint.hpp"
 
+namespace
+{
+constexpr const char *kIndexPath = "/index.html";
+// The only copy of the page in the image, see scripts/gzip_web_ui.py.
+constexpr const char *kCompressedIndexPath = "/index.html.gz";
+// Only these are served straight from flash. The rest of the filesystem holds
+// the settings journal and the asset store, which go through their own routes.
+constexpr const char *kFaviconPath = "/favicon.ico";
+constexpr const char *kAnimationDirectory = "/anims/";
+// The page has no versioned URL, so browsers revalidate it (a 304 when unchanged).
+constexpr const char *kIndexCacheControl = "no-cache";
+constexpr const char *kAssetCacheControl = "public, max-age=604800";
+constexpr size_t kGzipTrailerBytes = 8;
+}
+
 void StaticContentEndpoint::registerEndpoint(AsyncWebServer &server)
 {
   registerStaticContent(server);
@@ -7,5 +22,82 @@ void StaticContentEndpoint::registerEndpoint(AsyncWebServer &server)
 
 void StaticContentEndpoint::registerStaticContent(AsyncWebServer &server)
 {
-  server.serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
+  server.on("/", HTTP_GET, [this](AsyncWebServerRequest *request)
+            { handleIndex(request); });
+  server.on(kIndexPath, HTTP_GET, [this](AsyncWebServerRequest *request)
+            { handleIndex(request); });
+
+  // The compressed page is only reachable through the routes above, which send
+  // the right encoding and cache policy.
+  server.serveStatic(kFaviconPath, LittleFS, kFaviconPath)
+      .setCacheControl(kAssetCacheControl);
+  server.serveStatic(kAnimationDirectory, LittleFS, kAnimationDirectory)
+      .setCacheControl(kAssetCacheControl);
+}
+
+void StaticContentEndpoint::handleIndex(AsyncWebServerRequest *request)
+{
+  // Images built before the page was shipped compressed only hold index.html.
+  const bool compressed = LittleFS.exists(kCompressedIndexPath);
+  const char *path = compressed ? kCompressedIndexPath : kIndexPath;
+
+  const bool acceptsGzip = request->hasHeader("Accept-Encoding") &&
+                           request->getHeader("Accept-Encoding")->value().indexOf("gzip") >= 0;
+  if (compressed && !acceptsGzip)
+  {
+    request->send(406, "text/plain", F("The web UI is only available gzip-encoded."));
+    return;
+  }
+
+  File file = LittleFS.open(path, FILE_READ);
+  if (!file)
+  {
+    request->send(404, "text/plain", F("Web UI not found. Upload the filesystem image."));
+    return;
+  }
+
+  const String etag = buildETag(file, compressed);
+  if (request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == etag)
+  {
+    file.close();
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", kIndexCacheControl);
+    request->send(response);
+    return;
+  }
+
+  AsyncWebServerResponse *response = request->beginResponse(file, path, "text/html");
+  if (compressed)
+  {
+    response->addHeader("Content-Encoding", "gzip");
+  }
+  response->addHeader("Vary", "Accept-Encoding");
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", kIndexCacheControl);
+  request->send(response);
+}
+
+String StaticContentEndpoint::buildETag(File &file, bool compressed) const
+{
+  const size_t size = file.size();
+  uint32_t contentId = static_cast<uint32_t>(file.getLastWrite());
+
+  // The gzip trailer holds the CRC-32 of the page, which identifies the
+  // content independently of when the image was flashed.
+  if (compressed && size >= kGzipTrailerBytes && file.seek(size - kGzipTrailerBytes, SeekSet))
+  {
+    uint8_t trailer[4];
+    if (file.read(trailer, sizeof(trailer)) == sizeof(trailer))
+    {
+      contentId = static_cast<uint32_t>(trailer[0]) | (static_cast<uint32_t>(trailer[1]) << 8) |
+                  (static_cast<uint32_t>(trailer[2]) << 16) | (static_cast<uint32_t>(trailer[3]) << 24);
+    }
+  }
+  file.seek(0, SeekSet);
+
+  char etag[32];
+  snprintf(etag, sizeof(etag), "\"%s%lx-%lx\"", compressed ? "gz-" : "",
+           static_cast<unsigned long>(contentId), static_cast<unsigned long>(size));
+  return String(etag);
 }
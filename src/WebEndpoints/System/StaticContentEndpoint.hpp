@@ -10,6 +10,8 @@ public:
 
 private:
   void registerStaticContent(AsyncWebServer &server);
+  void handleIndex(AsyncWebServerRequest *request);
+  String buildETag(File &file, bool compressed) const;
 };
 
 #endif // WEB_ENDPOINTS_SYSTEM_STATIC_CONTENT_ENDPOINT_HPP
@@ -13,5 +13,6 @@ void SystemPowerEndpoint::handleGet(AsyncWebServerRequest *request) {
     return;
   }
 
+  // The last sample from the loop; the sensor is never read from this task.
   request->send(200, "text/plain", systemPowerController_.readPowerInfo());
 }
@@ -1,5 +1,7 @@
 #include "WebServerManager.hpp"
 
+#include "HeapMonitor.hpp"
+
 WebServerManager::WebServerManager(
     EmotionState &emotionState,
     FanController &fanController,
@@ -7,22 +9,36 @@ WebServerManager::WebServerManager(
     LedBrightnessController &brightnessController,
     TiltController &tiltController,
     SystemPowerController &systemPowerController,
+    const StateStore &stateStore,
     FileManager &fileManager,
     CapabilityManager &capabilityManager,
+    FrameStats &frameStats,
+    FramePreview &framePreview,
+    SettingsStorage &settingsStorage,
+    const BootSequencer &bootSequencer,
     std::function<void()> onSettingsChanged,
     bool allowAllFileChanges)
-    : server_(80),
+    : settingsStorage_(settingsStorage),
+      server_(80),
       staticContentEndpoint_(),
       fileEndpoint_(fileManager, allowAllFileChanges),
       filesEndpoint_(fileManager),
+      packEndpoint_(fileManager, emotionState, earController, onSettingsChanged, allowAllFileChanges),
       emotionsEndpoint_(emotionState),
       emotionEndpoint_(emotionState, earController, onSettingsChanged),
       heapEndpoint_(),
       fanEndpoint_(fanController, onSettingsChanged),
       earsEndpoint_(brightnessController, onSettingsChanged),
+      batchEndpoint_(emotionState, earController, brightnessController, fanController, onSettingsChanged),
       gyroEndpoint_(tiltController),
       systemPowerEndpoint_(systemPowerController),
       capabilitiesEndpoint_(capabilityManager),
+      displayStatsEndpoint_(frameStats),
+      eventsEndpoint_(fanController, brightnessController, tiltController, stateStore),
+      facePreviewEndpoint_(framePreview),
+      settingsEndpoint_(settingsStorage, onSettingsChanged),
+      settingsStatsEndpoint_(settingsStorage),
+      bootStatsEndpoint_(bootSequencer),
       notFoundEndpoint_()
 {
 }
@@ -34,13 +50,19 @@ void WebServerManager::begin(const char *ssid, const char *password)
   registerRoutes();
 
   ElegantOTA.begin(&server_);
+  // Pending settings must reach flash before the update reboots the device.
+  ElegantOTA.onStart([this]()
+                     { settingsStorage_.flush(); });
   server_.begin();
   ElegantOTA.setAutoReboot(true);
 }
 
 void WebServerManager::loop()
 {
+  HeapMonitor::Scope heapScope(HeapMonitor::Subsystem::Web);
   ElegantOTA.loop();
+  eventsEndpoint_.update();
+  facePreviewEndpoint_.update();
 }
 
 void WebServerManager::registerRoutes()
@@ -48,13 +70,21 @@ void WebServerManager::registerRoutes()
   staticContentEndpoint_.registerEndpoint(server_);
   fileEndpoint_.registerEndpoint(server_);
   filesEndpoint_.registerEndpoint(server_);
+  packEndpoint_.registerEndpoint(server_);
   emotionsEndpoint_.registerEndpoint(server_);
   emotionEndpoint_.registerEndpoint(server_);
   heapEndpoint_.registerEndpoint(server_);
   fanEndpoint_.registerEndpoint(server_);
   earsEndpoint_.registerEndpoint(server_);
+  batchEndpoint_.registerEndpoint(server_);
   gyroEndpoint_.registerEndpoint(server_);
   systemPowerEndpoint_.registerEndpoint(server_);
   capabilitiesEndpoint_.registerEndpoint(server_);
+  displayStatsEndpoint_.registerEndpoint(server_);
+  eventsEndpoint_.registerEndpoint(server_);
+  facePreviewEndpoint_.registerEndpoint(server_);
+  settingsEndpoint_.registerEndpoint(server_);
+  settingsStatsEndpoint_.registerEndpoint(server_);
+  bootStatsEndpoint_.registerEndpoint(server_);
   notFoundEndpoint_.registerEndpoint(server_);
 }
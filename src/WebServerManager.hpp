@@ -14,14 +14,25 @@
 #include "EmotionState.hpp"
 #include "FanController.hpp"
 #include "TiltController.hpp"
+#include "SettingsStorage.hpp"
+#include "BootSequencer.hpp"
+#include "StateStore.hpp"
 #include "SystemPowerController.hpp"
+#include "WebEndpoints/Batch/BatchEndpoint.hpp"
 #include "WebEndpoints/Ears/EarsEndpoint.hpp"
 #include "WebEndpoints/Fan/FanEndpoint.hpp"
 #include "WebEndpoints/Emotions/EmotionEndpoint.hpp"
 #include "WebEndpoints/Emotions/EmotionsEndpoint.hpp"
 #include "WebEndpoints/Files/FileEndpoint.hpp"
 #include "WebEndpoints/Files/FilesEndpoint.hpp"
+#include "WebEndpoints/Files/PackEndpoint.hpp"
+#include "WebEndpoints/System/BootStatsEndpoint.hpp"
+#include "WebEndpoints/System/DisplayStatsEndpoint.hpp"
+#include "WebEndpoints/System/EventsEndpoint.hpp"
+#include "WebEndpoints/System/FacePreviewEndpoint.hpp"
 #include "WebEndpoints/System/GyroEndpoint.hpp"
+#include "WebEndpoints/System/SettingsEndpoint.hpp"
+#include "WebEndpoints/System/SettingsStatsEndpoint.hpp"
 #include "WebEndpoints/System/SystemPowerEndpoint.hpp"
 #include "Capabilities/CapabilityManager.hpp"
 #include "WebEndpoints/Capabilities/CapabilitiesEndpoint.hpp"
@@ -34,8 +45,13 @@ public:
   WebServerManager(EmotionState &emotionState, FanController &fanController,
                    EarController &earController, LedBrightnessController &brightnessController, TiltController &tiltController,
                    SystemPowerController &systemPowerController,
+                   const StateStore &stateStore,
                    FileManager &fileManager,
                    CapabilityManager &capabilityManager,
+                   FrameStats &frameStats,
+                   FramePreview &framePreview,
+                   SettingsStorage &settingsStorage,
+                   const BootSequencer &bootSequencer,
                    std::function<void()> onSettingsChanged, bool allowAllFileChanges);
 
   void begin(const char *ssid, const char *password);
@@ -44,18 +60,27 @@ public:
 private:
   void registerRoutes();
 
+  SettingsStorage &settingsStorage_;
   AsyncWebServer server_;
   StaticContentEndpoint staticContentEndpoint_;
   FileEndpoint fileEndpoint_;
   FilesEndpoint filesEndpoint_;
+  PackEndpoint packEndpoint_;
   EmotionsEndpoint emotionsEndpoint_;
   EmotionEndpoint emotionEndpoint_;
   HeapEndpoint heapEndpoint_;
   FanEndpoint fanEndpoint_;
   EarsEndpoint earsEndpoint_;
+  BatchEndpoint batchEndpoint_;
   GyroEndpoint gyroEndpoint_;
   SystemPowerEndpoint systemPowerEndpoint_;
   CapabilitiesEndpoint capabilitiesEndpoint_;
+  DisplayStatsEndpoint displayStatsEndpoint_;
+  EventsEndpoint eventsEndpoint_;
+  FacePreviewEndpoint facePreviewEndpoint_;
+  SettingsEndpoint settingsEndpoint_;
+  SettingsStatsEndpoint settingsStatsEndpoint_;
+  BootStatsEndpoint bootStatsEndpoint_;
   NotFoundEndpoint notFoundEndpoint_;
 };
 
@@ -2,12 +2,14 @@
 #ifdef MAIN
 #include <Arduino.h>
 
+#include "BootSequencer.hpp"
 #include "FileManager.hpp"
 #include "DisplayManager.hpp"
 #include "EarController.hpp"
 #include "EmotionState.hpp"
 #include "FanController.hpp"
 #include "SettingsStorage.hpp"
+#include "StateStore.hpp"
 #include "TiltController.hpp"
 #include "SystemPowerController.hpp"
 #include "WebServerManager.hpp"
@@ -15,7 +17,8 @@
 #include "Capabilities/CapabilityManager.hpp"
 #include "config.hpp"
 
-LedBrightnessController ledBrightnessController;
+StateStore stateStore;
+LedBrightnessController ledBrightnessController(stateStore);
 
 #if defined(FACE_NEOPIXEL_OUT_L) && defined(FACE_NEOPIXEL_OUT_R) && defined(FACE_NEOPIXEL_PANEL_WIDTH) && defined(FACE_NEOPIXEL_PANEL_HEIGHT)
 #include "FaceDisplay/NeopixelFaceDisplay.hpp"
@@ -27,75 +30,113 @@ P3MatrixFaceDisplay faceDisplay(PANEL_RES_X, PANEL_RES_Y, PANEL_CHAIN);
 #error "No valid face display configuration found. Please define either Neopixel or HUB75 display parameters in config.hpp."
 #endif
 
-EmotionState emotionState;
-FanController fanController(FAN_PWM_PIN, FAN_PWM_CHANNEL, FAN_PWM_FREQUENCY, FAN_PWM_RESOLUTION);
+EmotionState emotionState(stateStore);
+FanController fanController(stateStore, FAN_PWM_PIN, FAN_PWM_CHANNEL, FAN_PWM_FREQUENCY, FAN_PWM_RESOLUTION);
 EarController earController(LEDS_PER_DISPLAY, DATA_PIN_EARS, ledBrightnessController);
 TiltController tiltController(emotionState, PIN_SDA, PIN_SCL);
-SystemPowerController systemPowerController(PIN_SDA, PIN_SCL);
+SystemPowerController systemPowerController(stateStore, PIN_SDA, PIN_SCL);
 FileManager fileManager;
 SettingsStorage settingsStorage(emotionState, fanController, ledBrightnessController, earController);
+BootSequencer bootSequencer(faceDisplay.getFrameStats());
 
 void onSettingsChanged()
 {
-  settingsStorage.save();
+  settingsStorage.markDirty();
 }
 CapabilityManager capabilityManager(ledBrightnessController, fanController, onSettingsChanged);
 WebServerManager webServerManager(emotionState, fanController, earController, ledBrightnessController,
-                                  tiltController, systemPowerController, fileManager,
+                                  tiltController, systemPowerController, stateStore, fileManager,
                                   capabilityManager,
+                                  faceDisplay.getFrameStats(),
+                                  faceDisplay.getFramePreview(),
+                                  settingsStorage,
+                                  bootSequencer,
                                   onSettingsChanged, 
                                   ALLOW_ALL_FILE_CHANGES);
-DisplayManager displayManager(PIN_SDA, PIN_SCL, emotionState, fanController, ledBrightnessController, systemPowerController);
-BLEController bleController(emotionState, capabilityManager, earController);
+DisplayManager displayManager(PIN_SDA, PIN_SCL, stateStore, fanController, ledBrightnessController, systemPowerController);
+BLEController bleController(emotionState, capabilityManager, earController, fanController, stateStore,
+                            faceDisplay.getFrameStats());
+
+size_t webServerStage = BootSequencer::kMaxStages;
+size_t oledStage = BootSequencer::kMaxStages;
+size_t bleStage = BootSequencer::kMaxStages;
+StateStore::Snapshot renderState;
 
 void setup() {
   Serial.begin(115200);
 
-  tiltController.begin();
-  systemPowerController.begin();
-
-  if (!fileManager.begin()) {
+  // Only what the first face frame needs runs here; the rest is deferred.
+  if (!bootSequencer.run("filesystem", [] { return fileManager.begin(); })) {
     while (true) {
       delay(1000);
     }
   }
 
-
-  if (!faceDisplay.begin()) {
+  if (!bootSequencer.run("face display", [] { return faceDisplay.begin(); })) {
     while (true) {
       delay(1000);
     }
   }
+  faceDisplay.setPathResolver([](const String &path) { return fileManager.resolvePath(path); });
 
-  fileManager.printEmotions();
-
-  fanController.begin();
-
-  if (!earController.begin()) {
+  if (!bootSequencer.run("ears", [] { return earController.begin(); })) {
     Serial.println(F("[E] Starting LED driver failed"));
   }
 
-  if (!settingsStorage.load())
-  {
+  bootSequencer.run("fan", [] {
+    fanController.begin();
+    return true;
+  });
+
+  if (!bootSequencer.run("settings", [] { return settingsStorage.load(); })) {
     Serial.println(F("[W] Continuing with default settings due to load error."));
   }
 
-  webServerManager.begin(WIFI_NAME, WIFI_PASS);
-
-  displayManager.begin();
-
-  if(!bleController.begin()) {
+  // Sensors and the OLED share the I2C bus with the loop, so they start there.
+  bootSequencer.defer("tilt sensor", BootSequencer::Mode::Loop, [] { return tiltController.begin(); });
+  bootSequencer.defer("power sensor", BootSequencer::Mode::Loop, [] { return systemPowerController.begin(); });
+  oledStage = bootSequencer.defer("oled", BootSequencer::Mode::Loop, [] {
+    displayManager.begin();
+    return true;
+  });
+
+  webServerStage = bootSequencer.defer("web server", BootSequencer::Mode::Background, [] {
+    webServerManager.begin(WIFI_NAME, WIFI_PASS);
+    return true;
+  });
+  bleStage = bootSequencer.defer("ble", BootSequencer::Mode::Background, [] {
+    if (!bleController.begin()) {
       Serial.println(F("[E] An Error has occurred while starting BLE!"));
+      return false;
     }
-
-  Serial.println(F("[I] Init done"));
+    return true;
+  });
+  bootSequencer.defer("file listing", BootSequencer::Mode::Background, [] {
+    fileManager.printEmotions();
+    return true;
+  });
+
+  bootSequencer.finishSetup();
 }
 
 void loop() {
-  webServerManager.loop();
+  if (bootSequencer.isDone(webServerStage)) {
+    webServerManager.loop();
+  }
   tiltController.update();
-  faceDisplay.playEmotion(emotionState.getCurrentEmotion());
+  systemPowerController.update();
+  // Never blocks, even while a web or BLE handler is changing the state.
+  stateStore.read(renderState);
+  faceDisplay.playEmotion(renderState.emotionRevision, renderState.emotionPath);
+  bootSequencer.update();
   earController.update();
-  displayManager.update();
+  if (bootSequencer.isDone(oledStage)) {
+    displayManager.update();
+  }
+  // A failed BLE bring-up leaves the controller without a server to update.
+  if (bootSequencer.hasSucceeded(bleStage)) {
+    bleController.update();
+  }
+  settingsStorage.update();
 }
 #endif